@@ -0,0 +1,82 @@
+#include "AllocAudit.h"
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// No <stdlib.h> or <malloc.h> here, their declarations of malloc would
+// clash with ours. <stdio.h> is only for __GLIBC__.
+static thread_local long allocations = 0;
+
+#if defined(OMAHAWATCH_ALLOC_AUDIT) && defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+	++allocations;
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size)
+{
+	++allocations;
+	return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+	++allocations;
+	return __libc_realloc(ptr, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+	++allocations;
+	return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+	++allocations;
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+	if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+		return EINVAL;
+	}
+	++allocations;
+	void* p = __libc_memalign(alignment, size);
+	if (!p) {
+		return ENOMEM;
+	}
+	*ptr = p;
+	return 0;
+}
+
+void free(void* ptr)
+{
+	__libc_free(ptr);
+}
+}
+
+bool AllocAudit::Available()
+{
+	return true;
+}
+#else
+bool AllocAudit::Available()
+{
+	return false;
+}
+#endif
+
+long AllocAudit::Count()
+{
+	return allocations;
+}
@@ -0,0 +1,17 @@
+#ifndef _ALLOCAUDIT_H_
+#define _ALLOCAUDIT_H_
+
+/*
+ * Counts heap allocations made by the calling thread. The simulator binary
+ * replaces malloc and friends to do it, which only works with glibc and
+ * without sanitizers; Available() tells whether the counts mean anything.
+ */
+class AllocAudit
+{
+public:
+	static bool Available();
+	// Allocations on this thread since the program started
+	static long Count();
+};
+
+#endif
@@ -0,0 +1,595 @@
+#include "DaySimulator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "AllocAudit.h"
+#include "Log.h"
+#include "WorkerPool.h"
+
+// Rough costs for a Gear class watch. Only meant for comparing schedules.
+static constexpr double frameEnergy = 0.002;          // J per animator frame
+static constexpr double tickEnergy = 0.003;           // J per face wakeup
+static constexpr double sensorWakeupEnergy = 0.002;   // J per sensor delivery
+static constexpr double locationPower = 0.06;         // W while the service is on
+static constexpr double httpEnergy = 0.5;             // J per request, mostly radio tail
+static constexpr double byteEnergy = 0.000005;        // J per byte
+static constexpr double batteryVoltage = 3.8;
+
+static constexpr int framesPerSecond = 60;
+
+struct Walk
+{
+	int from; // minute of the day
+	int to;
+	int stepsPerMinute;
+};
+
+static const Walk Walks[] = {
+		{ 8 * 60, 8 * 60 + 30, 100 },
+		{ 12 * 60 + 30, 13 * 60, 100 },
+		{ 18 * 60, 19 * 60, 110 }
+};
+static constexpr int idleStepsPerMinute = 4;
+
+// OpenWeatherMap's answer, the rest of the profile's bytes is padding
+static const char WeatherResponse[] = "{\"name\":\"London\",\"weather\":[{\"icon\":\"01d\"}],\"main\":{\"temp\":285.1}}";
+static const char BadResponse[] = "<html><body>502 Bad Gateway</body></html>";
+
+DaySimulator::Profile DaySimulator::DefaultProfile()
+{
+	Profile profile;
+	profile.wakeHour = 7;
+	profile.sleepHour = 23;
+	profile.alwaysOn = true;
+	profile.offWrist = false;
+	profile.quiet = true;
+	profile.glanceInterval = 12 * 60;
+	profile.glanceSeconds = 8;
+	profile.fixLatency = 15;
+	profile.batteryStart = 100;
+	profile.drainPerHour = 3;
+	profile.responseBytes = 1200;
+	profile.latitude = 51.5;
+	profile.longitude = -0.13;
+	return profile;
+}
+
+double DaySimulator::ToMah(double energy)
+{
+	return energy / batteryVoltage / 3.6;
+}
+
+DaySimulator::DaySimulator(HostPlatform& platform, const Profile& profile):
+	platform_(platform),
+	profile_(profile),
+	controller_(this),
+	replay_(nullptr),
+	tracePath_(nullptr),
+	start_(0),
+	paused_(false),
+	ambient_(false),
+	animating_(false),
+	settling_(true),
+	hands_(),
+	eventsSeen_(0),
+	locationRunning_(false),
+	locationStarted_(0),
+	fixLatency_(profile.fixLatency),
+	lastMinute_(-1),
+	lastDay_(-1),
+	steps_(0),
+	asleep_(false),
+	nightStartEnergy_(0),
+	lastSample_(0),
+	lastDelivered_(-1),
+	pendingSamples_(0),
+	batchStart_(0),
+	weatherFile_(),
+	weatherUrl_(),
+	servedError_(-1),
+	servedLatency_(0),
+	servedBytes_(-1),
+	httpRequestsSeen_(0),
+	resultsDue_(0)
+{
+	memset(&report_, 0, sizeof(report_));
+	memset(&stats_, 0, sizeof(stats_));
+}
+
+DaySimulator::~DaySimulator()
+{
+	if (weatherFile_[0]) {
+		unlink(weatherFile_);
+	}
+}
+
+const DaySimulator::Report& DaySimulator::Run(time_t start, int seconds)
+{
+	start_ = start;
+	platform_.clock.Set(start);
+	this->start(start);
+	for (int i = 0; i < seconds; ++i) {
+		time_t now = start + i;
+		// A replayed clock change keeps its offset
+		platform_.clock.Set(now + (replay_ ? replay_->GetState().clockOffset : 0));
+		step(now);
+	}
+	updateNight(start + seconds, false);
+
+	Stats::Snapshot stats;
+	Stats::Take(stats);
+	report_.timerFirings = stats.values[Stats::TIMER_CALLBACKS] - stats_.values[Stats::TIMER_CALLBACKS];
+	report_.httpRequests = stats.values[Stats::HTTP_REQUESTS] - stats_.values[Stats::HTTP_REQUESTS];
+	HostSensorDevice* pedometer = platform_.sensors.Find(Sensors::KIND_PEDOMETER);
+	report_.sensorReads = pedometer ? pedometer->Reads() : 0;
+	report_.steps = (long)steps_;
+	report_.energy = estimateEnergy();
+	return report_;
+}
+
+void DaySimulator::start(time_t now)
+{
+	Stats::Take(stats_);
+	httpRequestsSeen_ = stats_.values[Stats::HTTP_REQUESTS];
+	if (!createWeatherFile()) {
+		LOG_E("No weather file, every request fails");
+	}
+	controller_.SetWeatherUrl(weatherUrl_);
+	if (profile_.quiet) {
+		controller_.SetQuietSchedule({ profile_.sleepHour * 60, profile_.wakeHour * 60,
+				QuietMode::DefaultSchedule().inactivity, QuietMode::DefaultSchedule().preWake });
+	} else {
+		controller_.SetQuietSchedule(QuietMode::NoSchedule());
+	}
+	if (tracePath_) {
+		controller_.OpenTrace(tracePath_);
+	}
+	drainBattery(now);
+	serveWeather(now);
+	controller_.Init();
+	controller_.SetupSensors(nullptr);
+	controller_.SetupLocation();
+	scanEvents();
+	runWeatherResults(now);
+	watchLocation(now);
+}
+
+void DaySimulator::step(time_t now)
+{
+	struct tm timeInfo;
+	localtime_r(&now, &timeInfo);
+	bool awake = timeInfo.tm_hour >= profile_.wakeHour && timeInfo.tm_hour < profile_.sleepHour;
+	bool ticked = true;
+	serveWeather(now);
+	long before = AllocAudit::Count();
+	if (replay_) {
+		ticked = replayStep(now);
+	} else {
+		wearerStep(now, timeInfo, awake);
+	}
+	account(before, nullptr);
+	updateNight(now, !awake);
+	platform_.sensors.SetValue(Sensors::KIND_PEDOMETER, (int)steps_);
+	deliverSteps(now);
+	runLocation(now);
+
+	// Stage deadlines are main loop timers and fire while paused
+	before = AllocAudit::Count();
+	platform_.mainLoop.RunTimeouts();
+	account(before, nullptr);
+
+	// time_tick every second while visible, ambient_tick once a minute.
+	// A replay ticks when the watch did.
+	long minute = now / 60;
+	if (!paused_ && ticked) {
+		if (!ambient_) {
+			++report_.ticks;
+			tick(now, &report_.tickAllocs);
+			if (animating_) {
+				// One frame stands for the rest of the second
+				report_.animatorFrames += framesPerSecond;
+				frame();
+			}
+		} else if (replay_ || minute != lastMinute_) {
+			++report_.ambientTicks;
+			tick(now, &report_.ambientTickAllocs);
+		}
+	}
+	runWeatherResults(now);
+	watchLocation(now);
+}
+
+void DaySimulator::wearerStep(time_t now, const struct tm& timeInfo, bool awake)
+{
+	int dayMinute = timeInfo.tm_hour * 60 + timeInfo.tm_min;
+	int daySecond = dayMinute * 60 + timeInfo.tm_sec;
+	bool looking = awake && (daySecond - profile_.wakeHour * 3600) % profile_.glanceInterval < profile_.glanceSeconds;
+	bool paused = !looking && !(profile_.alwaysOn && (awake || !profile_.offWrist));
+	bool ambient = !looking && !paused;
+	if (paused != paused_ || ambient != ambient_) {
+		setVisibility(paused, ambient);
+	}
+
+	int stepsPerMinute = awake ? idleStepsPerMinute : 0;
+	for (const auto& walk: Walks) {
+		if (dayMinute >= walk.from && dayMinute < walk.to) {
+			stepsPerMinute = walk.stepsPerMinute;
+		}
+	}
+	drainBattery(now);
+	steps_ += stepsPerMinute / 60.0;
+}
+
+bool DaySimulator::replayStep(time_t now)
+{
+	bool ticked = replay_->Advance(now, platform_.clock);
+	const TraceReplay::State& state = replay_->GetState();
+	if (state.paused != paused_ || state.ambient != ambient_) {
+		setVisibility(state.paused, state.ambient);
+	}
+	if (state.steps >= 0) {
+		steps_ = state.steps;
+	}
+	if (state.battery >= 0) {
+		platform_.battery.Set(state.battery, state.charging);
+	}
+	platform_.connectivity.SetOnline(state.online);
+	return ticked;
+}
+
+void DaySimulator::setVisibility(bool paused, bool ambient)
+{
+	// In the order the watch app calls Face
+	if (ambient != ambient_) {
+		ambient_ = ambient;
+		controller_.SetAmbient(ambient);
+	}
+	if (paused != paused_) {
+		paused_ = paused;
+		if (paused) {
+			controller_.Pause();
+		} else {
+			controller_.Resume();
+		}
+	}
+}
+
+void DaySimulator::tick(time_t now, long* steadyAllocs)
+{
+	// The face ticks with the wall clock, a replay may have set it
+	time_t clockNow = (time_t)platform_.clock.Now();
+	struct tm timeInfo;
+	localtime_r(&clockNow, &timeInfo);
+	if (timeInfo.tm_mday != lastDay_) {
+		// The step log and the date start the new day
+		lastDay_ = timeInfo.tm_mday;
+		settling_ = true;
+	}
+	lastMinute_ = now / 60;
+	long before = AllocAudit::Count();
+	controller_.Tick(clockNow, 0);
+	account(before, steadyAllocs);
+}
+
+void DaySimulator::frame()
+{
+	long before = AllocAudit::Count();
+	controller_.Frame();
+	account(before, &report_.frameAllocs);
+}
+
+bool DaySimulator::MoveHands(const HandAngles& angles)
+{
+	bool moved = angles.hour != hands_.hour || angles.minute != hands_.minute ||
+			(angles.secondShown && angles.second != hands_.second);
+	hands_ = angles;
+	return moved;
+}
+
+void DaySimulator::account(long before, long* steadyAllocs)
+{
+	long allocs = AllocAudit::Count() - before;
+	// Weather refreshes are reported on their own, whatever started them
+	if (scanEvents()) {
+		report_.weatherAllocs += allocs;
+		return;
+	}
+	if (!steadyAllocs) {
+		return;
+	}
+	if (settling_) {
+		report_.settleAllocs += allocs;
+	} else {
+		*steadyAllocs += allocs;
+	}
+	settling_ = false;
+}
+
+bool DaySimulator::scanEvents()
+{
+	// The controller's event ring tells what it did since the last look
+	EventRing& events = controller_.Events();
+	uint32_t added = events.Sequence() - eventsSeen_;
+	eventsSeen_ = events.Sequence();
+	int size = events.Size();
+	if (added > (uint32_t)size) {
+		added = size;
+	}
+	bool weather = false;
+	for (int i = size - (int)added; i < size; ++i) {
+		EventRing::Event event;
+		int arg0, arg1;
+		events.Get(i, &event, &arg0, &arg1);
+		switch (event) {
+		case EventRing::EVENT_WEATHER_TIMER:
+			++report_.weatherRefreshes;
+			weather = true;
+			break;
+		case EventRing::EVENT_PRE_WAKE:
+			++report_.preWakeRefreshes;
+			weather = true;
+			break;
+		case EventRing::EVENT_CURL_FAILED:
+		case EventRing::EVENT_JSON_ERROR:
+			++report_.httpFailures;
+			weather = true;
+			break;
+		case EventRing::EVENT_REFRESH:
+			if (arg0 == RefreshPipeline::STAGE_LOCATION && arg1 == RefreshPipeline::OUTCOME_TIMEOUT) {
+				++report_.locationTimeouts;
+			}
+			weather = true;
+			break;
+		case EventRing::EVENT_WEATHER_REQUEST:
+		case EventRing::EVENT_CURL_WARNING:
+		case EventRing::EVENT_LOCATION_STATE:
+		case EventRing::EVENT_LOCATION_FAILED:
+		case EventRing::EVENT_LOCATION_METHOD:
+		case EventRing::EVENT_LOCATION_START_FAILED:
+		case EventRing::EVENT_LOCATION_STOP_FAILED:
+		case EventRing::EVENT_TIMER_FAILED:
+			weather = true;
+			break;
+		case EventRing::EVENT_POWER_TIER:
+			++report_.tierChanges;
+			settling_ = true;
+			break;
+		case EventRing::EVENT_QUIET:
+			LOG_I("Quiet mode %s", arg0 ? "on" : "off");
+			settling_ = true;
+			break;
+		case EventRing::EVENT_TIME_CHANGED:
+			settling_ = true;
+			break;
+		default:
+			break;
+		}
+	}
+	return weather;
+}
+
+void DaySimulator::drainBattery(time_t now)
+{
+	double hours = (now - start_) / 3600.0;
+	int percent = profile_.batteryStart - (int)(hours * profile_.drainPerHour);
+	if (percent < 1) {
+		percent = 1;
+	}
+	platform_.battery.Set(percent, false);
+}
+
+void DaySimulator::updateNight(time_t now, bool asleep)
+{
+	if (asleep == asleep_) {
+		if (asleep && report_.nightsNum > 0) {
+			Night& night = report_.nights[report_.nightsNum - 1];
+			++night.seconds;
+			night.quietSeconds += controller_.Quiet();
+		}
+		return;
+	}
+	asleep_ = asleep;
+	if (asleep) {
+		if (report_.nightsNum == maxNights) {
+			return;
+		}
+		Night& night = report_.nights[report_.nightsNum++];
+		night.start = now;
+		night.seconds = 0;
+		night.quietSeconds = 0;
+		night.energy = 0;
+		nightStartEnergy_ = estimateEnergy();
+	} else if (report_.nightsNum > 0) {
+		report_.nights[report_.nightsNum - 1].energy = estimateEnergy() - nightStartEnergy_;
+	}
+}
+
+void DaySimulator::deliverSteps(time_t now)
+{
+	// The pedometer reports a changed counter once per interval. With a
+	// batch latency the samples are held back and delivered in one wakeup.
+	HostSensorDevice* device = platform_.sensors.Find(Sensors::KIND_PEDOMETER);
+	if (!device || !device->Running() || !device->HasCallback()) {
+		pendingSamples_ = 0;
+		return;
+	}
+	int counter = (int)steps_;
+	int interval = device->Interval() / 1000 > 0 ? device->Interval() / 1000 : 1;
+	if (now - lastSample_ >= interval) {
+		lastSample_ = now;
+		if (counter != lastDelivered_) {
+			lastDelivered_ = counter;
+			if (device->BatchLatency() == 0) {
+				device->Inject(counter);
+				++report_.sensorCallbacks;
+				++report_.sensorWakeups;
+			} else {
+				if (pendingSamples_ == 0) {
+					batchStart_ = now;
+				}
+				++pendingSamples_;
+			}
+		}
+	}
+	if (pendingSamples_ > 0 && now - batchStart_ >= device->BatchLatency() / 1000) {
+		for (int i = 0; i < pendingSamples_; ++i) {
+			device->Inject(counter);
+		}
+		report_.sensorCallbacks += pendingSamples_;
+		++report_.sensorWakeups;
+		pendingSamples_ = 0;
+	}
+}
+
+void DaySimulator::runLocation(time_t now)
+{
+	if (!platform_.location.Running()) {
+		return;
+	}
+	++report_.locationOnSeconds;
+	if (fixLatency_ > 0 && now - locationStarted_ >= fixLatency_) {
+		platform_.location.SetFix(profile_.latitude, profile_.longitude, (time_t)platform_.clock.Now());
+		++report_.locationFixes;
+		long before = AllocAudit::Count();
+		platform_.location.DeliverFix();
+		account(before, nullptr);
+	}
+}
+
+void DaySimulator::watchLocation(time_t now)
+{
+	// The controller starts the service, its fix comes after the profile's
+	// or the recorded latency
+	bool running = platform_.location.Running();
+	if (running && !locationRunning_) {
+		locationStarted_ = now;
+		fixLatency_ = profile_.fixLatency;
+		if (replay_) {
+			int latency = replay_->FixLatency(now);
+			if (latency >= 0) {
+				fixLatency_ = latency;
+			}
+		}
+	}
+	locationRunning_ = running;
+}
+
+bool DaySimulator::createWeatherFile()
+{
+	const char* dir = getenv("TMPDIR");
+	snprintf(weatherFile_, sizeof(weatherFile_), "%s/omahawatch_weather_XXXXXX", dir && dir[0] ? dir : "/tmp");
+	int fd = mkstemp(weatherFile_);
+	snprintf(weatherUrl_, sizeof(weatherUrl_), "file://%s", weatherFile_);
+	if (fd < 0) {
+		weatherFile_[0] = '\0';
+		return false;
+	}
+	close(fd);
+	return true;
+}
+
+void DaySimulator::serveWeather(time_t now)
+{
+	// What a request sent in this second gets. Without a replay the
+	// response is in before the next simulated second.
+	int error = 0;
+	int latency = 0;
+	int bytes = profile_.responseBytes;
+	if (replay_) {
+		replay_->Http(now, &error, &latency, &bytes);
+	}
+	servedLatency_ = latency;
+	if (!weatherFile_[0] || (error == servedError_ && bytes == servedBytes_)) {
+		return;
+	}
+	servedError_ = error;
+	servedBytes_ = bytes;
+	if (bytes == 0) {
+		// curl can't read the file and fails the request
+		unlink(weatherFile_);
+		return;
+	}
+	std::string body = error == Trace::httpBadResponse ? BadResponse : WeatherResponse;
+	if ((int)body.size() < bytes) {
+		body.append(bytes - body.size(), ' ');
+	}
+	FILE* file = fopen(weatherFile_, "w");
+	if (!file) {
+		LOG_E("Failed to write %s", weatherFile_);
+		return;
+	}
+	fwrite(body.data(), 1, body.size(), file);
+	fclose(file);
+}
+
+void DaySimulator::runWeatherResults(time_t now)
+{
+	// Requests run on the real worker pool, the simulated second waits for them
+	WorkerPool& workers = WorkerPool::GetInstance();
+	while (!workers.Idle()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	Stats::Snapshot stats;
+	Stats::Take(stats);
+	uint32_t requests = stats.values[Stats::HTTP_REQUESTS];
+	report_.httpBytes += (long)(requests - httpRequestsSeen_) * servedBytes_;
+	httpRequestsSeen_ = requests;
+
+	if (platform_.mainLoop.Posted() == 0) {
+		return;
+	}
+	if (resultsDue_ == 0) {
+		resultsDue_ = now + servedLatency_ / 1000;
+	}
+	if (now < resultsDue_) {
+		return;
+	}
+	resultsDue_ = 0;
+	long before = AllocAudit::Count();
+	platform_.mainLoop.RunPosted();
+	report_.weatherAllocs += AllocAudit::Count() - before;
+	scanEvents();
+}
+
+double DaySimulator::estimateEnergy() const
+{
+	return report_.animatorFrames * frameEnergy +
+			(report_.ticks + report_.ambientTicks) * tickEnergy +
+			report_.sensorWakeups * sensorWakeupEnergy +
+			report_.locationOnSeconds * locationPower +
+			report_.httpRequests * httpEnergy +
+			report_.httpBytes * byteEnergy;
+}
+
+void DaySimulator::Print(const Report& report, int seconds, FILE* out)
+{
+	fprintf(out, "Simulated %.1f h\n", seconds / 3600.0);
+	fprintf(out, "  animator frames    %ld\n", report.animatorFrames);
+	fprintf(out, "  time ticks         %ld\n", report.ticks);
+	fprintf(out, "  ambient ticks      %ld\n", report.ambientTicks);
+	fprintf(out, "  timer firings      %ld\n", report.timerFirings);
+	fprintf(out, "  sensor callbacks   %ld in %ld wakeups, %ld reads\n", report.sensorCallbacks, report.sensorWakeups, report.sensorReads);
+	fprintf(out, "  location on        %ld s, %ld fixes, %ld timeouts\n", report.locationOnSeconds, report.locationFixes, report.locationTimeouts);
+	fprintf(out, "  http requests      %ld, %ld bytes, %ld failed\n", report.httpRequests, report.httpBytes, report.httpFailures);
+	fprintf(out, "  power tier changes %ld\n", report.tierChanges);
+	fprintf(out, "  steps              %ld\n", report.steps);
+	fprintf(out, "  estimated energy   %.1f J (%.2f mAh)\n", report.energy, ToMah(report.energy));
+	fprintf(out, "  pre-wake refreshes %ld\n", report.preWakeRefreshes);
+	for (int i = 0; i < report.nightsNum; ++i) {
+		const Night& night = report.nights[i];
+		struct tm startInfo;
+		localtime_r(&night.start, &startInfo);
+		char startStr[32];
+		strftime(startStr, sizeof(startStr), "%a %H:%M", &startInfo);
+		fprintf(out, "  night from %s %.1f h, %.1f h quiet, %.1f J (%.2f mAh)\n", startStr,
+				night.seconds / 3600.0, night.quietSeconds / 3600.0, night.energy, ToMah(night.energy));
+	}
+	if (AllocAudit::Available()) {
+		fprintf(out, "  heap allocations   %ld in ticks, %ld in ambient ticks, %ld in frames, %ld settling\n",
+				report.tickAllocs, report.ambientTickAllocs, report.frameAllocs, report.settleAllocs);
+		fprintf(out, "  weather refreshes  %ld, %ld allocations\n", report.weatherRefreshes, report.weatherAllocs);
+	}
+}
@@ -0,0 +1,172 @@
+#ifndef _DAYSIMULATOR_H_
+#define _DAYSIMULATOR_H_
+#include <limits.h>
+#include <stdio.h>
+#include <time.h>
+#include "HostPlatform.h"
+#include "FaceController.h"
+#include "FaceView.h"
+#include "HandAngles.h"
+#include "Stats.h"
+#include "TraceReplay.h"
+
+/*
+ * Replays hours of the face on a virtual clock and adds up what it costs.
+ * It runs the same FaceController as Face on the host platform: ticks,
+ * frames, the weather timer, location requests and the pedometer policy
+ * are the watch's own code, only the drawing is left out. Weather requests
+ * go through curl to a file the simulator writes. The wearer is described
+ * by Profile, or by a trace recorded on the watch.
+ */
+class DaySimulator: public FaceView
+{
+public:
+	struct Profile
+	{
+		int wakeHour;        // local time
+		int sleepHour;
+		bool alwaysOn;       // ambient while not looked at, otherwise paused
+		bool offWrist;       // taken off overnight, paused even with alwaysOn
+		bool quiet;          // quiet mode over the sleep hours
+		int glanceInterval;  // seconds between wrist raises while awake
+		int glanceSeconds;
+		int fixLatency;      // seconds until a started location service has a fix, 0 - never
+		int batteryStart;    // percent
+		double drainPerHour; // percent
+		int responseBytes;   // weather request and response together
+		double latitude;
+		double longitude;
+	};
+
+	// Sleep hours, from falling asleep or the start of the run
+	struct Night
+	{
+		time_t start;
+		long seconds;
+		long quietSeconds;
+		double energy; // J
+	};
+
+	static constexpr int maxNights = 8;
+
+	struct Report
+	{
+		long animatorFrames;
+		long ticks;
+		long ambientTicks;
+		long timerFirings;
+		long sensorCallbacks;
+		long sensorWakeups;
+		long sensorReads;
+		long locationOnSeconds;
+		long locationFixes;
+		long locationTimeouts;
+		long httpRequests;
+		long httpBytes;
+		long httpFailures;
+		long tierChanges;
+		long steps;
+		double energy; // J, estimated
+		long preWakeRefreshes;
+		Night nights[maxNights];
+		int nightsNum;
+
+		// Heap allocations on the main thread, see AllocAudit. Ticks that
+		// start a run or cross into a new day, day plan, power tier or quiet
+		// mode do one-off work and count as settling. Whatever a weather
+		// refresh does, from its timer to the fetched result, counts as
+		// weather.
+		long tickAllocs;
+		long ambientTickAllocs;
+		long frameAllocs;
+		long settleAllocs;
+		long weatherRefreshes;
+		long weatherAllocs;
+	};
+
+	static Profile DefaultProfile();
+	static double ToMah(double energy);
+
+	DaySimulator(HostPlatform& platform, const Profile& profile);
+	~DaySimulator();
+
+	// Inputs come from the trace instead of the profile. Sleep hours and
+	// the location stay with the profile.
+	void SetReplay(TraceReplay* replay) { replay_ = replay; }
+	// Records the inputs the simulated face gets, as Face does on the watch
+	void Record(const char* path) { tracePath_ = path; }
+
+	const Report& Run(time_t start, int seconds);
+	static void Print(const Report& report, int seconds, FILE* out);
+
+	// What the controller shows, only the hands and the animator matter here
+	void SetText(Text text, const char* value) override {}
+	void SetIcon(Icon icon, const char* file) override {}
+	// The plan is built again at each sun event, one-off work like a new day
+	void PlaceSunIcons(const DayPlan& plan) override { settling_ = true; }
+	bool MoveHands(const HandAngles& angles) override;
+	void ShowSecondHand(bool shown) override {}
+	void SetAnimating(bool animating) override { animating_ = animating; }
+private:
+	void start(time_t now);
+	void step(time_t now);
+	void wearerStep(time_t now, const struct tm& timeInfo, bool awake);
+	bool replayStep(time_t now);
+	void setVisibility(bool paused, bool ambient);
+	void tick(time_t now, long* steadyAllocs);
+	void frame();
+	void account(long before, long* steadyAllocs);
+	bool scanEvents();
+	void drainBattery(time_t now);
+	void updateNight(time_t now, bool asleep);
+	void deliverSteps(time_t now);
+	void runLocation(time_t now);
+	void watchLocation(time_t now);
+	bool createWeatherFile();
+	void serveWeather(time_t now);
+	void runWeatherResults(time_t now);
+	double estimateEnergy() const;
+
+	HostPlatform& platform_;
+	Profile profile_;
+	Report report_;
+	FaceController controller_;
+	Stats::Snapshot stats_;
+
+	TraceReplay* replay_;
+	const char* tracePath_;
+
+	time_t start_;
+	bool paused_;
+	bool ambient_;
+	bool animating_;
+	bool settling_;
+	HandAngles hands_;
+	uint32_t eventsSeen_;
+	bool locationRunning_;
+	time_t locationStarted_;
+	int fixLatency_;
+	long lastMinute_;
+	int lastDay_;
+	double steps_;
+	bool asleep_;
+	double nightStartEnergy_;
+
+	// Pedometer delivery
+	time_t lastSample_;
+	int lastDelivered_;
+	int pendingSamples_;
+	time_t batchStart_;
+
+	// Weather response the requests get, a file:// address for curl
+	char weatherFile_[PATH_MAX];
+	char weatherUrl_[PATH_MAX + 8];
+	int servedError_;   // as in Trace::KIND_HTTP
+	int servedLatency_; // ms
+	int servedBytes_;
+	uint32_t httpRequestsSeen_;
+	// Results posted by the workers are run then, 0 - none waiting
+	time_t resultsDue_;
+};
+
+#endif
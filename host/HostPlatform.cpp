@@ -0,0 +1,363 @@
+#include "HostPlatform.h"
+#include <algorithm>
+#include <stdio.h>
+#include <time.h>
+
+static double SystemTime(clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+HostClock::HostClock():
+	virtual_(false),
+	now_(0),
+	monotonic_(0),
+	cb_(nullptr),
+	data_(nullptr)
+{
+}
+
+double HostClock::Now()
+{
+	return virtual_ ? now_ : SystemTime(CLOCK_REALTIME);
+}
+
+double HostClock::Monotonic()
+{
+	return virtual_ ? monotonic_ : SystemTime(CLOCK_BOOTTIME);
+}
+
+void HostClock::Set(double now)
+{
+	if (!virtual_) {
+		monotonic_ = SystemTime(CLOCK_BOOTTIME);
+		virtual_ = true;
+	}
+	if (now > now_) {
+		monotonic_ += now - now_;
+	}
+	now_ = now;
+}
+
+void HostClock::Advance(double seconds)
+{
+	Set(Now() + seconds);
+}
+
+void HostClock::Change(double now)
+{
+	// Only the wall clock moves
+	double monotonic = Monotonic();
+	Set(now);
+	monotonic_ = monotonic;
+	if (cb_) {
+		cb_(data_);
+	}
+}
+
+void HostLogger::Write(Level level, const char* msg)
+{
+	static const char levels[] = { 'V', 'D', 'I', 'W', 'E' };
+	if (level < level_) {
+		return;
+	}
+	fprintf(stderr, "[%c] %s\n", levels[level], msg);
+}
+
+HostSensorDevice::HostSensorDevice(HostSensors* owner, Sensors::Kind kind):
+	owner_(owner),
+	kind_(kind),
+	running_(false),
+	interval_(0),
+	batchLatency_(0),
+	hasValue_(false),
+	value_(0),
+	reads_(0),
+	cb_(nullptr),
+	data_(nullptr)
+{
+}
+
+HostSensorDevice::~HostSensorDevice()
+{
+	owner_->Remove(this);
+}
+
+bool HostSensorDevice::Start()
+{
+	running_ = true;
+	return true;
+}
+
+void HostSensorDevice::Stop()
+{
+	running_ = false;
+}
+
+void HostSensorDevice::SetCallback(int interval, int batchLatency, EventCallback cb, void* data)
+{
+	interval_ = interval;
+	batchLatency_ = batchLatency;
+	cb_ = cb;
+	data_ = data;
+}
+
+bool HostSensorDevice::Read(float* value)
+{
+	if (!running_ || !hasValue_) {
+		return false;
+	}
+	*value = value_;
+	++reads_;
+	return true;
+}
+
+void HostSensorDevice::SetValue(float value)
+{
+	value_ = value;
+	hasValue_ = true;
+}
+
+void HostSensorDevice::Inject(float value)
+{
+	if (!running_) {
+		return;
+	}
+	SetValue(value);
+	if (cb_) {
+		cb_(value, data_);
+	}
+}
+
+HostSensors::HostSensors()
+{
+	std::fill(available_, available_ + kindsNum, true);
+}
+
+SensorDevice* HostSensors::Open(Kind kind)
+{
+	if (!available_[kind]) {
+		return nullptr;
+	}
+	HostSensorDevice* device = new HostSensorDevice(this, kind);
+	device->Start();
+	devices_.push_back(device);
+	return device;
+}
+
+void HostSensors::SetAvailable(Kind kind, bool available)
+{
+	available_[kind] = available;
+}
+
+HostSensorDevice* HostSensors::Find(Kind kind)
+{
+	for (auto device: devices_) {
+		if (device->GetKind() == kind) {
+			return device;
+		}
+	}
+	return nullptr;
+}
+
+void HostSensors::SetValue(Kind kind, float value)
+{
+	for (auto device: devices_) {
+		if (device->GetKind() == kind) {
+			device->SetValue(value);
+		}
+	}
+}
+
+void HostSensors::Inject(Kind kind, float value)
+{
+	for (auto device: devices_) {
+		if (device->GetKind() == kind) {
+			device->Inject(value);
+		}
+	}
+}
+
+void HostSensors::Remove(HostSensorDevice* device)
+{
+	devices_.erase(std::remove(devices_.begin(), devices_.end(), device), devices_.end());
+}
+
+HostLocation::HostLocation():
+	open_(false),
+	unavailable_(false),
+	running_(false),
+	hasFix_(false),
+	latitude_(0),
+	longitude_(0),
+	timestamp_(0),
+	cb_(nullptr),
+	data_(nullptr)
+{
+}
+
+bool HostLocation::Open(LocationScheduler::Method method, StateCallback cb, void* data)
+{
+	if (unavailable_) {
+		return false;
+	}
+	open_ = true;
+	cb_ = cb;
+	data_ = data;
+	return true;
+}
+
+void HostLocation::Close()
+{
+	open_ = false;
+	running_ = false;
+	cb_ = nullptr;
+}
+
+bool HostLocation::Start()
+{
+	if (!open_) {
+		return false;
+	}
+	running_ = true;
+	return true;
+}
+
+bool HostLocation::Stop()
+{
+	if (!open_) {
+		return false;
+	}
+	bool wasRunning = running_;
+	running_ = false;
+	if (wasRunning && cb_) {
+		cb_(STATE_DISABLED, data_);
+	}
+	return true;
+}
+
+bool HostLocation::Position(double* latitude, double* longitude, time_t* timestamp)
+{
+	if (!running_ || !hasFix_) {
+		return false;
+	}
+	return LastPosition(latitude, longitude, timestamp);
+}
+
+bool HostLocation::LastPosition(double* latitude, double* longitude, time_t* timestamp)
+{
+	if (!hasFix_) {
+		return false;
+	}
+	*latitude = latitude_;
+	*longitude = longitude_;
+	*timestamp = timestamp_;
+	return true;
+}
+
+void HostLocation::SetFix(double latitude, double longitude, time_t timestamp)
+{
+	latitude_ = latitude;
+	longitude_ = longitude;
+	timestamp_ = timestamp;
+	hasFix_ = true;
+}
+
+void HostLocation::DeliverFix()
+{
+	if (running_ && cb_) {
+		cb_(STATE_ENABLED, data_);
+	}
+}
+
+void HostBattery::Set(int percent, bool charging)
+{
+	if (percent == percent_ && charging == charging_) {
+		return;
+	}
+	percent_ = percent;
+	charging_ = charging;
+	if (cb_) {
+		cb_(data_);
+	}
+}
+
+void HostConnectivity::SetOnline(bool online)
+{
+	if (online == online_) {
+		return;
+	}
+	online_ = online;
+	if (cb_) {
+		cb_(data_);
+	}
+}
+
+HostMainLoop::HostMainLoop(Clock& clock):
+	clock_(clock),
+	timeouts_()
+{
+}
+
+void HostMainLoop::Post(Callback cb, void* data)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	posted_.push_back({ cb, data });
+}
+
+MainLoop::Timeout* HostMainLoop::AddTimeout(double seconds, Callback cb, void* data)
+{
+	for (Timeout& timeout: timeouts_) {
+		if (!timeout.armed) {
+			timeout = { clock_.Monotonic() + seconds, cb, data, true };
+			return &timeout;
+		}
+	}
+	return nullptr;
+}
+
+void HostMainLoop::DeleteTimeout(Timeout* timeout)
+{
+	timeout->armed = false;
+}
+
+int HostMainLoop::Posted()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return (int)posted_.size();
+}
+
+void HostMainLoop::RunPosted()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		running_.swap(posted_);
+	}
+	// Callbacks may post again, those run next time
+	for (const Job& job: running_) {
+		job.cb(job.data);
+	}
+	running_.clear();
+}
+
+int HostMainLoop::RunTimeouts()
+{
+	int run = 0;
+	double now = clock_.Monotonic();
+	for (Timeout& timeout: timeouts_) {
+		if (timeout.armed && timeout.due <= now) {
+			// Disarmed first, the callback may add the next one
+			timeout.armed = false;
+			timeout.cb(timeout.data);
+			++run;
+		}
+	}
+	return run;
+}
+
+void HostPlatform::Install()
+{
+	Platform::Install({ &clock, &logger, &sensors, &location, &battery, &connectivity, &mainLoop });
+}
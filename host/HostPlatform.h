@@ -0,0 +1,229 @@
+#ifndef _HOSTPLATFORM_H_
+#define _HOSTPLATFORM_H_
+#include "Platform.h"
+#include <mutex>
+#include <vector>
+
+/*
+ * Linux host implementation of the platform services. Everything is driven
+ * by the caller: the clock runs in real time until it's set, sensors report
+ * injected values and location fixes are delivered on request.
+ */
+
+class HostClock: public Clock
+{
+public:
+	HostClock();
+
+	double Now() override;
+	double Monotonic() override;
+	void SetChangedCallback(ChangedCallback cb, void* data) override { cb_ = cb; data_ = data; }
+
+	// Switches to virtual time
+	void Set(double now);
+	void Advance(double seconds);
+	// Sets the time like the user would, subscribers are told. The
+	// monotonic clock stays where it is.
+	void Change(double now);
+private:
+	bool virtual_;
+	double now_;
+	double monotonic_;
+	ChangedCallback cb_;
+	void* data_;
+};
+
+class HostLogger: public Logger
+{
+public:
+	HostLogger(): level_(LEVEL_INFO) {}
+
+	void Write(Level level, const char* msg) override;
+	void SetLevel(Level level) { level_ = level; }
+private:
+	Level level_;
+};
+
+class HostSensors;
+
+class HostSensorDevice: public SensorDevice
+{
+public:
+	HostSensorDevice(HostSensors* owner, Sensors::Kind kind);
+	~HostSensorDevice();
+
+	bool Start() override;
+	void Stop() override;
+	void SetCallback(int interval, int batchLatency, EventCallback cb, void* data) override;
+	bool Read(float* value) override;
+
+	Sensors::Kind GetKind() const { return kind_; }
+	// Reads that returned a value
+	long Reads() const { return reads_; }
+	bool Running() const { return running_; }
+	bool HasCallback() const { return cb_ != nullptr; }
+	int Interval() const { return interval_; }
+	int BatchLatency() const { return batchLatency_; }
+	// Value seen by Read, no callback
+	void SetValue(float value);
+	// Value delivered through the callback, if one is set
+	void Inject(float value);
+private:
+	HostSensors* owner_;
+	Sensors::Kind kind_;
+	bool running_;
+	int interval_;
+	int batchLatency_;
+	bool hasValue_;
+	float value_;
+	long reads_;
+	EventCallback cb_;
+	void* data_;
+};
+
+class HostSensors: public Sensors
+{
+public:
+	HostSensors();
+
+	SensorDevice* Open(Kind kind) override;
+
+	void SetAvailable(Kind kind, bool available);
+	// First open device of this kind or nullptr
+	HostSensorDevice* Find(Kind kind);
+	void SetValue(Kind kind, float value);
+	// Updates the value and calls back every device of this kind with a callback set
+	void Inject(Kind kind, float value);
+	void Remove(HostSensorDevice* device);
+private:
+	static constexpr int kindsNum = KIND_PRESSURE + 1;
+
+	bool available_[kindsNum];
+	std::vector<HostSensorDevice*> devices_;
+};
+
+class HostLocation: public LocationSource
+{
+public:
+	HostLocation();
+
+	bool Open(LocationScheduler::Method method, StateCallback cb, void* data) override;
+	void Close() override;
+	bool IsOpen() override { return open_; }
+	bool Start() override;
+	bool Stop() override;
+	bool Position(double* latitude, double* longitude, time_t* timestamp) override;
+	bool LastPosition(double* latitude, double* longitude, time_t* timestamp) override;
+
+	void SetFix(double latitude, double longitude, time_t timestamp);
+	// Open fails, as on a device without a location service
+	void SetUnavailable(bool unavailable) { unavailable_ = unavailable; }
+	bool Running() const { return running_; }
+	// Reports the service as enabled, as the device does once a fix is acquired
+	void DeliverFix();
+private:
+	bool open_;
+	bool unavailable_;
+	bool running_;
+	bool hasFix_;
+	double latitude_;
+	double longitude_;
+	time_t timestamp_;
+	StateCallback cb_;
+	void* data_;
+};
+
+class HostBattery: public Battery
+{
+public:
+	HostBattery(): percent_(100), charging_(false), cb_(nullptr), data_(nullptr) {}
+
+	bool Percent(int* percent) override { *percent = percent_; return true; }
+	bool Charging(bool* charging) override { *charging = charging_; return true; }
+	void SetChangedCallback(ChangedCallback cb, void* data) override { cb_ = cb; data_ = data; }
+
+	// Calls back if anything changed
+	void Set(int percent, bool charging);
+private:
+	int percent_;
+	bool charging_;
+	ChangedCallback cb_;
+	void* data_;
+};
+
+class HostConnectivity: public Connectivity
+{
+public:
+	HostConnectivity(): online_(true), cb_(nullptr), data_(nullptr) {}
+
+	bool Online() override { return online_; }
+	void SetChangedCallback(ChangedCallback cb, void* data) override { cb_ = cb; data_ = data; }
+	int Proxy(std::string& proxy) override { proxy.clear(); return 0; }
+
+	// Calls back if the state changed
+	void SetOnline(bool online);
+private:
+	bool online_;
+	ChangedCallback cb_;
+	void* data_;
+};
+
+// One-shot timer on the clock's monotonic time
+struct MainLoop::Timeout
+{
+	double due;
+	Callback cb;
+	void* data;
+	bool armed;
+};
+
+/*
+ * Nothing runs on its own: the caller runs what was posted and the timeouts
+ * that are due, usually once per simulated second.
+ */
+class HostMainLoop: public MainLoop
+{
+public:
+	explicit HostMainLoop(Clock& clock);
+
+	void Post(Callback cb, void* data) override;
+	Timeout* AddTimeout(double seconds, Callback cb, void* data) override;
+	void DeleteTimeout(Timeout* timeout) override;
+
+	// Callbacks posted and not run yet
+	int Posted();
+	void RunPosted();
+	// Returns the number of timeouts run
+	int RunTimeouts();
+private:
+	struct Job
+	{
+		Callback cb;
+		void* data;
+	};
+
+	// More than the face ever has at once
+	static constexpr int timeoutsNum = 4;
+
+	Clock& clock_;
+	std::mutex mutex_;
+	std::vector<Job> posted_;
+	std::vector<Job> running_;
+	Timeout timeouts_[timeoutsNum];
+};
+
+class HostPlatform
+{
+public:
+	void Install();
+
+	HostClock clock;
+	HostLogger logger;
+	HostSensors sensors;
+	HostLocation location;
+	HostBattery battery;
+	HostConnectivity connectivity;
+	HostMainLoop mainLoop{clock};
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "WeatherInfo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// No json-glib on the host. Only the three fields the face uses are looked
+// up, by key, which is enough for OpenWeatherMap responses.
+
+static const char* findValue(const char* json, const char* key)
+{
+	char quoted[32];
+	snprintf(quoted, sizeof(quoted), "\"%s\"", key);
+	const char* found = strstr(json, quoted);
+	if (!found) {
+		return nullptr;
+	}
+	found += strlen(quoted);
+	found += strspn(found, " \t\r\n");
+	if (*found != ':') {
+		return nullptr;
+	}
+	++found;
+	return found + strspn(found, " \t\r\n");
+}
+
+static bool findString(const char* json, const char* key, char* out, size_t len)
+{
+	const char* value = findValue(json, key);
+	if (!value || *value != '"') {
+		return false;
+	}
+	++value;
+	size_t valueLen = strcspn(value, "\"");
+	if (value[valueLen] != '"' || valueLen >= len) {
+		return false;
+	}
+	memcpy(out, value, valueLen);
+	out[valueLen] = '\0';
+	return true;
+}
+
+bool WeatherInfo::FromJson(const char* json)
+{
+	if (json[strspn(json, " \t\r\n")] != '{') {
+		return false;
+	}
+	char name[128];
+	char icon[16];
+	if (!findString(json, "name", name, sizeof(name)) || !findString(json, "icon", icon, sizeof(icon))) {
+		return false;
+	}
+	const char* temp = findValue(json, "temp");
+	if (!temp) {
+		return false;
+	}
+	char* end = nullptr;
+	double kelvin = strtod(temp, &end);
+	if (end == temp) {
+		return false;
+	}
+	set(name, icon, kelvin);
+	return true;
+}
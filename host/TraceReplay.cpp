@@ -0,0 +1,149 @@
+#include "TraceReplay.h"
+#include "Platform.h"
+
+TraceReplay::TraceReplay():
+	startMs_(0),
+	next_(0),
+	state_({ false, false, -1, -1, false, true, 0 }),
+	tickTime_(0),
+	ticksLeft_(0)
+{
+}
+
+bool TraceReplay::Load(const char* path)
+{
+	double start = 0;
+	if (!Trace::Load(path, &start, records_)) {
+		return false;
+	}
+	startMs_ = (int64_t)(start * 1000);
+	index();
+	return true;
+}
+
+int TraceReplay::Seconds() const
+{
+	if (records_.empty()) {
+		return 0;
+	}
+	const Trace::Record& last = records_.back();
+	uint32_t end = last.time;
+	if (last.kind == Trace::KIND_TICK) {
+		end += (last.count - 1) * 1000;
+	}
+	return (int)(end / 1000) + 1;
+}
+
+bool TraceReplay::Advance(time_t now, HostClock& clock)
+{
+	bool ticked = takeTicks(now);
+	for (; next_ < records_.size() && secondOf(records_[next_].time) <= now; ++next_) {
+		const Trace::Record& record = records_[next_];
+		switch (record.kind) {
+		case Trace::KIND_TICK:
+			tickTime_ = record.time;
+			ticksLeft_ = record.count;
+			ticked = takeTicks(now) || ticked;
+			break;
+		case Trace::KIND_VISIBILITY:
+			state_.paused = record.args[0];
+			state_.ambient = record.args[1];
+			break;
+		case Trace::KIND_SENSOR:
+			if (record.args[0] == Sensors::KIND_PEDOMETER) {
+				state_.steps = record.args[1];
+			}
+			break;
+		case Trace::KIND_BATTERY:
+			state_.battery = record.args[0];
+			state_.charging = record.args[1];
+			break;
+		case Trace::KIND_CONNECTIVITY:
+			state_.online = record.args[0];
+			break;
+		case Trace::KIND_TIME_CHANGED:
+			state_.clockOffset = record.args[0];
+			clock.Change((double)now + state_.clockOffset);
+			break;
+		default:
+			// Location and HTTP are looked up when the face asks for them
+			break;
+		}
+	}
+	return ticked;
+}
+
+int TraceReplay::FixLatency(time_t started) const
+{
+	if (sessions_.empty()) {
+		return -1;
+	}
+	for (const Session& session: sessions_) {
+		if (session.start >= started) {
+			return session.latency;
+		}
+	}
+	return sessions_.back().latency;
+}
+
+bool TraceReplay::Http(time_t sent, int* error, int* latency, int* bytes) const
+{
+	if (responses_.empty()) {
+		return false;
+	}
+	const Response* response = &responses_.back();
+	for (const Response& candidate: responses_) {
+		if (candidate.time >= sent) {
+			response = &candidate;
+			break;
+		}
+	}
+	*error = response->error;
+	*latency = response->latency;
+	*bytes = response->bytes;
+	return true;
+}
+
+bool TraceReplay::takeTicks(time_t now)
+{
+	bool ticked = false;
+	while (ticksLeft_ > 0 && secondOf(tickTime_) <= now) {
+		ticked = true;
+		tickTime_ += 1000;
+		--ticksLeft_;
+	}
+	return ticked;
+}
+
+void TraceReplay::index()
+{
+	// A session ends with its fix, or without one when the service stops
+	sessions_.clear();
+	responses_.clear();
+	bool open = false;
+	for (const Trace::Record& record: records_) {
+		switch (record.kind) {
+		case Trace::KIND_LOCATION_START:
+			sessions_.push_back({ secondOf(record.time), 0 });
+			open = true;
+			break;
+		case Trace::KIND_LOCATION_FIX:
+			if (open) {
+				Session& session = sessions_.back();
+				int latency = (int)(secondOf(record.time) - session.start);
+				session.latency = latency > 0 ? latency : 1;
+				open = false;
+			}
+			break;
+		case Trace::KIND_LOCATION_STOP:
+			open = false;
+			break;
+		case Trace::KIND_HTTP:
+			responses_.push_back({ secondOf(record.time) - record.args[1] / 1000,
+						record.args[0], record.args[1], record.count });
+			break;
+		default:
+			break;
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#ifndef _TRACEREPLAY_H_
+#define _TRACEREPLAY_H_
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+#include "HostPlatform.h"
+#include "Trace.h"
+
+/*
+ * Feeds a recorded Trace to the simulator in place of the wearer profile.
+ * Ticks, visibility, steps, battery, network and clock changes follow the
+ * records one simulated second at a time. Simulated seconds are the
+ * trace's monotonic time; the face's wall clock runs clockOffset ahead. Location fixes and HTTP results are taken
+ * from the recorded session nearest to when the simulated face asks for
+ * them, so a changed schedule still meets the real day's latencies and
+ * failures.
+ */
+class TraceReplay
+{
+public:
+	struct State
+	{
+		bool paused;
+		bool ambient;
+		int steps;    // -1 - none recorded yet
+		int battery;  // percent, -1 - none recorded yet
+		bool charging;
+		bool online;
+		int clockOffset; // seconds, see Trace::KIND_TIME_CHANGED
+	};
+
+	TraceReplay();
+
+	bool Load(const char* path);
+	double Start() const { return startMs_ / 1000.0; }
+	int Seconds() const;
+	long Records() const { return (long)records_.size(); }
+
+	// Applies the records up to the end of the second. A recorded clock
+	// change sets the clock to now plus the new offset, which tells the
+	// face. Returns true if the face ticked during it.
+	bool Advance(time_t now, HostClock& clock);
+	const State& GetState() const { return state_; }
+
+	// Seconds from a location start to its fix, 0 - never, -1 - no session recorded
+	int FixLatency(time_t started) const;
+	// Result of a weather request sent at the time, as recorded in
+	// Trace::KIND_HTTP. Returns false if no request was recorded.
+	bool Http(time_t sent, int* error, int* latency, int* bytes) const;
+private:
+	struct Session
+	{
+		time_t start;
+		int latency;
+	};
+
+	struct Response
+	{
+		time_t time; // sent
+		int error;
+		int latency; // ms
+		int bytes;
+	};
+
+	time_t secondOf(uint32_t time) const { return (time_t)((startMs_ + time) / 1000); }
+	bool takeTicks(time_t now);
+	void index();
+
+	std::vector<Trace::Record> records_;
+	std::vector<Session> sessions_;
+	std::vector<Response> responses_;
+	int64_t startMs_;
+	size_t next_;
+	State state_;
+
+	// The tick run being replayed
+	uint32_t tickTime_;
+	int ticksLeft_;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "DaySimulator.h"
+#include "AllocAudit.h"
+#include "Stats.h"
+#include "TraceReplay.h"
+#include "WorkerPool.h"
+#include <curl/curl.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+			"Usage: %s [options]\n"
+			"  --hours H          simulated time, default 24, or the length of a replayed trace\n"
+			"  --start TIME       unix time to start at, default last local midnight\n"
+			"  --replay FILE      inputs from a trace recorded on the watch instead of the profile\n"
+			"  --record FILE      record the inputs of the simulated face as a trace\n"
+			"  --no-aod           face paused instead of ambient when not looked at\n"
+			"  --off-wrist        face paused overnight, the watch is not worn\n"
+			"  --no-quiet         no quiet mode over the sleep hours\n"
+			"  --glance S         seconds between wrist raises, default 720\n"
+			"  --battery P        battery level at start, default 100\n"
+			"  --drain P          battery drain per hour, default 3\n"
+			"  --fix-latency S    seconds to a location fix, 0 - never, default 15\n"
+			"  --budget MAH       exit with 1 if the estimate is over the budget\n"
+			"  --alloc-audit      exit with 1 if steady-state ticks or frames allocate\n"
+			"  -v                 log from the simulated components\n", name);
+}
+
+int main(int argc, char** argv)
+{
+	DaySimulator::Profile profile = DaySimulator::DefaultProfile();
+	double hours = 0;
+	double budget = 0;
+	time_t start = 0;
+	bool verbose = false;
+	bool allocAudit = false;
+	const char* replayPath = nullptr;
+	const char* recordPath = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!strcmp(arg, "--no-aod")) {
+			profile.alwaysOn = false;
+		} else if (!strcmp(arg, "--off-wrist")) {
+			profile.offWrist = true;
+		} else if (!strcmp(arg, "--no-quiet")) {
+			profile.quiet = false;
+		} else if (!strcmp(arg, "--alloc-audit")) {
+			allocAudit = true;
+		} else if (!strcmp(arg, "-v")) {
+			verbose = true;
+		} else if (value && !strcmp(arg, "--hours")) {
+			hours = atof(value);
+			++i;
+		} else if (value && !strcmp(arg, "--start")) {
+			start = (time_t)atoll(value);
+			++i;
+		} else if (value && !strcmp(arg, "--replay")) {
+			replayPath = value;
+			++i;
+		} else if (value && !strcmp(arg, "--record")) {
+			recordPath = value;
+			++i;
+		} else if (value && !strcmp(arg, "--glance")) {
+			profile.glanceInterval = atoi(value);
+			++i;
+		} else if (value && !strcmp(arg, "--battery")) {
+			profile.batteryStart = atoi(value);
+			++i;
+		} else if (value && !strcmp(arg, "--drain")) {
+			profile.drainPerHour = atof(value);
+			++i;
+		} else if (value && !strcmp(arg, "--fix-latency")) {
+			profile.fixLatency = atoi(value);
+			++i;
+		} else if (value && !strcmp(arg, "--budget")) {
+			budget = atof(value);
+			++i;
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (profile.glanceInterval <= 0 || hours < 0) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	if (allocAudit && !AllocAudit::Available()) {
+		fprintf(stderr, "Allocation audit needs a glibc build without sanitizers\n");
+		return 2;
+	}
+
+	TraceReplay replay;
+	if (replayPath) {
+		if (!replay.Load(replayPath)) {
+			fprintf(stderr, "Failed to load trace %s\n", replayPath);
+			return 2;
+		}
+		// Replayed records are in the trace's own time
+		start = (time_t)replay.Start();
+		if (hours == 0) {
+			hours = replay.Seconds() / 3600.0;
+		}
+		printf("Replaying %s, %ld records\n", replayPath, replay.Records());
+	}
+	if (hours == 0) {
+		hours = 24;
+	}
+
+	if (start == 0) {
+		time_t now = time(NULL);
+		struct tm dayInfo;
+		localtime_r(&now, &dayInfo);
+		dayInfo.tm_hour = 0;
+		dayInfo.tm_min = 0;
+		dayInfo.tm_sec = 0;
+		dayInfo.tm_isdst = -1;
+		start = mktime(&dayInfo);
+	}
+
+	HostPlatform platform;
+	platform.logger.SetLevel(verbose ? Logger::LEVEL_DEBUG : Logger::LEVEL_WARN);
+	platform.Install();
+
+	// Before the workers use it, curl's own lazy init isn't thread safe
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	int seconds = (int)(hours * 3600);
+	DaySimulator simulator(platform, profile);
+	if (replayPath) {
+		simulator.SetReplay(&replay);
+	}
+	if (recordPath) {
+		simulator.Record(recordPath);
+	}
+	const DaySimulator::Report& report = simulator.Run(start, seconds);
+	DaySimulator::Print(report, seconds, stdout);
+	WorkerPool::GetInstance().Shutdown();
+	curl_global_cleanup();
+
+	Stats::Snapshot stats;
+	Stats::Take(stats);
+	for (int i = 0; i < Stats::COUNTERS_NUM; ++i) {
+		if (stats.values[i]) {
+			printf("  %-18s %u\n", Stats::Name((Stats::Counter)i), stats.values[i]);
+		}
+	}
+	for (int i = 0; i < stats.timersNum; ++i) {
+		printf("  timer %-12s %u callbacks\n", stats.timers[i].name, stats.timers[i].callbacks);
+	}
+
+	if (allocAudit && (report.tickAllocs || report.ambientTickAllocs || report.frameAllocs)) {
+		printf("Steady-state ticks or frames allocate\n");
+		return 1;
+	}
+	if (budget > 0 && DaySimulator::ToMah(report.energy) > budget) {
+		printf("Over budget: %.2f mAh > %.2f mAh\n", DaySimulator::ToMah(report.energy), budget);
+		return 1;
+	}
+	return 0;
+}
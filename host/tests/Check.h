@@ -0,0 +1,22 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+#include <stdio.h>
+
+/*
+ * Just enough of a test harness for the host tests: failed checks are
+ * printed and counted, main returns CHECK_RESULT() for ctest.
+ */
+static int checkFailures = 0;
+
+#define CHECK(cond, ...) do { \
+		if (!(cond)) { \
+			++checkFailures; \
+			printf("%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} while (0)
+
+#define CHECK_RESULT() (checkFailures ? (printf("%d checks failed\n", checkFailures), 1) : 0)
+
+#endif
@@ -0,0 +1,239 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <curl/curl.h>
+#include "Check.h"
+#include "FaceController.h"
+#include "HostPlatform.h"
+
+/*
+ * FaceController on the host platform, one simulated second at a time.
+ * Weather requests go through curl to a file, as in the simulator.
+ */
+static HostPlatform platform;
+static double now = 1718870400; // 2024-06-20 08:00 UTC
+static char weatherFile[PATH_MAX];
+static char weatherUrl[PATH_MAX + 8];
+
+static const char WeatherResponse[] = "{\"name\":\"London\",\"weather\":[{\"icon\":\"01d\"}],\"main\":{\"temp\":285.1}}";
+
+class TestView: public FaceView
+{
+public:
+	void SetText(Text text, const char* value) override { texts[text] = value; }
+	void SetIcon(Icon icon, const char* file) override {}
+	void PlaceSunIcons(const DayPlan& plan) override {}
+	bool MoveHands(const HandAngles& angles) override { return true; }
+	void ShowSecondHand(bool shown) override {}
+	void SetAnimating(bool animating) override {}
+
+	std::string texts[TEXTS_NUM];
+};
+
+static void writeWeather()
+{
+	FILE* file = fopen(weatherFile, "w");
+	if (file) {
+		fputs(WeatherResponse, file);
+		fclose(file);
+	}
+}
+
+static void start(FaceController& controller)
+{
+	controller.SetWeatherUrl(weatherUrl);
+	controller.Init();
+	controller.SetupSensors(nullptr);
+	controller.SetupLocation();
+}
+
+static void finishFetches()
+{
+	while (!WorkerPool::GetInstance().Idle()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	platform.mainLoop.RunPosted();
+}
+
+// Visible face: a time tick every second. Returns the seconds the location
+// service was on.
+static int run(FaceController& controller, int seconds)
+{
+	int locationOn = 0;
+	for (int i = 0; i < seconds; ++i) {
+		now += 1;
+		platform.clock.Set(now);
+		platform.mainLoop.RunTimeouts();
+		controller.Tick((time_t)now, 0);
+		finishFetches();
+		locationOn += platform.location.Running();
+	}
+	return locationOn;
+}
+
+static int countEvents(EventRing& events, EventRing::Event wanted, int arg0 = -1, int arg1 = -1)
+{
+	int count = 0;
+	for (int i = 0; i < events.Size(); ++i) {
+		EventRing::Event event;
+		int eventArg0, eventArg1;
+		events.Get(i, &event, &eventArg0, &eventArg1);
+		if (event == wanted && (arg0 < 0 || arg0 == eventArg0) && (arg1 < 0 || arg1 == eventArg1)) {
+			++count;
+		}
+	}
+	return count;
+}
+
+static void testLastPositionReuse()
+{
+	TestView view;
+	FaceController controller(&view);
+	start(controller);
+	CHECK(platform.location.Running(), "no fix yet, the location service should start");
+	run(controller, 2 * 60 + 1);
+	CHECK(!platform.location.Running(), "the location stage should have timed out");
+
+	// Another app gets a fix before the next weather timer
+	platform.location.SetFix(51.5, -0.13, (time_t)now);
+	int locationOn = run(controller, 10 * 60);
+	CHECK(locationOn == 0, "location on for %d s despite a fresh last position", locationOn);
+	CHECK(view.texts[FaceView::TEXT_WEATHER] == "London", "weather text '%s'", view.texts[FaceView::TEXT_WEATHER].c_str());
+}
+
+static void noTimeout(void* data)
+{
+}
+
+static void testExpireWithoutDeadline()
+{
+	// Every main loop timeout is taken, the stage deadline can't be added
+	MainLoop::Timeout* taken[4];
+	for (auto& timeout: taken) {
+		timeout = platform.mainLoop.AddTimeout(24 * 60 * 60, noTimeout, nullptr);
+	}
+	// Too old to reuse
+	platform.location.SetFix(51.5, -0.13, (time_t)now - 24 * 60 * 60);
+
+	TestView view;
+	FaceController controller(&view);
+	start(controller);
+	CHECK(platform.location.Running(), "an old fix should start the location service");
+	CHECK(countEvents(controller.Events(), EventRing::EVENT_TIMER_FAILED) == 1, "no timer failure recorded");
+
+	// The next weather timer ends the stage in place of the deadline
+	int locationOn = run(controller, 10 * 60);
+	CHECK(!platform.location.Running(), "location still on after the weather timer");
+	CHECK(locationOn < 10 * 60, "location on for the whole interval");
+	CHECK(countEvents(controller.Events(), EventRing::EVENT_REFRESH, RefreshPipeline::STAGE_LOCATION, RefreshPipeline::OUTCOME_TIMEOUT) == 1,
+			"location stage not expired");
+
+	for (auto timeout: taken) {
+		if (timeout) {
+			platform.mainLoop.DeleteTimeout(timeout);
+		}
+	}
+}
+
+static void testQuietEndRetries()
+{
+	// Quiet from now for half an hour, no pre-wake refresh
+	time_t seconds = (time_t)now;
+	struct tm timeInfo;
+	localtime_r(&seconds, &timeInfo);
+	int minute = timeInfo.tm_hour * 60 + timeInfo.tm_min;
+	QuietMode::Schedule schedule = { minute, (minute + 30) % (24 * 60), 0, 0 };
+	platform.connectivity.SetOnline(false);
+
+	TestView view;
+	FaceController controller(&view);
+	controller.SetQuietSchedule(schedule);
+	start(controller);
+	run(controller, 61);
+	CHECK(controller.Quiet(), "not quiet inside the window");
+
+	// Back online while quiet, the missed refresh waits
+	int refreshes = countEvents(controller.Events(), EventRing::EVENT_WEATHER_TIMER);
+	platform.connectivity.SetOnline(true);
+	CHECK(countEvents(controller.Events(), EventRing::EVENT_WEATHER_TIMER) == refreshes, "refreshed while quiet");
+
+	int left = 31 * 60;
+	while (controller.Quiet() && left-- > 0) {
+		run(controller, 1);
+	}
+	CHECK(!controller.Quiet(), "still quiet after the window");
+	CHECK(countEvents(controller.Events(), EventRing::EVENT_WEATHER_TIMER) == refreshes + 1, "missed refresh not made up when quiet ended");
+}
+
+static void testFetchFailure()
+{
+	platform.location.SetFix(51.5, -0.13, (time_t)now);
+	unlink(weatherFile);
+
+	TestView view;
+	FaceController controller(&view);
+	start(controller);
+	finishFetches();
+	CHECK(countEvents(controller.Events(), EventRing::EVENT_CURL_FAILED) == 1, "unreadable response not reported");
+	CHECK(view.texts[FaceView::TEXT_WEATHER].empty(), "weather text '%s' without a response", view.texts[FaceView::TEXT_WEATHER].c_str());
+	writeWeather();
+}
+
+static void testLocationUnavailable()
+{
+	// Another app's fix, but the face can't open the location service
+	platform.location.SetFix(51.5, -0.13, (time_t)now);
+	platform.location.SetUnavailable(true);
+
+	TestView view;
+	FaceController controller(&view);
+	controller.SetWeatherUrl(weatherUrl);
+	controller.Init();
+	CHECK(!controller.SetupLocation(), "location set up without a location service");
+	finishFetches();
+	CHECK(view.texts[FaceView::TEXT_WEATHER] == "London", "weather text '%s' for the last position", view.texts[FaceView::TEXT_WEATHER].c_str());
+
+	// The weather timer keeps the weather coming and tries the service again
+	view.texts[FaceView::TEXT_WEATHER].clear();
+	int refreshes = countEvents(controller.Events(), EventRing::EVENT_WEATHER_TIMER);
+	run(controller, 10 * 60);
+	CHECK(countEvents(controller.Events(), EventRing::EVENT_WEATHER_TIMER) > refreshes, "no weather timer without a location service");
+	CHECK(view.texts[FaceView::TEXT_WEATHER] == "London", "weather text '%s' after the timer", view.texts[FaceView::TEXT_WEATHER].c_str());
+	platform.location.SetUnavailable(false);
+	run(controller, 10 * 60);
+	CHECK(platform.location.IsOpen(), "location service not opened once available");
+}
+
+int main()
+{
+	setenv("TZ", "UTC", 1);
+	tzset();
+	platform.logger.SetLevel(Logger::LEVEL_ERROR);
+	platform.Install();
+	platform.clock.Set(now);
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	const char* dir = getenv("TMPDIR");
+	snprintf(weatherFile, sizeof(weatherFile), "%s/omahawatch_test_XXXXXX", dir && dir[0] ? dir : "/tmp");
+	int fd = mkstemp(weatherFile);
+	CHECK(fd >= 0, "no temporary file %s", weatherFile);
+	close(fd);
+	snprintf(weatherUrl, sizeof(weatherUrl), "file://%s", weatherFile);
+	writeWeather();
+
+	testLastPositionReuse();
+	testExpireWithoutDeadline();
+	testQuietEndRetries();
+	testFetchFailure();
+	testLocationUnavailable();
+
+	unlink(weatherFile);
+	WorkerPool::GetInstance().Shutdown();
+	curl_global_cleanup();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Check.h"
+#include "SolarCalc.h"
+
+/*
+ * Sunrise and sunset against reference times. The references were found
+ * by bisecting the sun's altitude to -0.833 degrees with the solar position
+ * of Meeus, Astronomical Algorithms ch. 25, independent of the closed form
+ * hour angle SolarCalc uses, and agree with published almanac times.
+ * Local times, rounded to the minute; "" - no such event that day.
+ */
+struct Reference
+{
+	const char* city;
+	const char* zone;
+	double latitude;
+	double longitude;
+	int year;
+	int month;
+	int day;
+	const char* sunrise;
+	const char* sunset;
+};
+
+static const Reference References[] = {
+		{ "London", "Europe/London", 51.5074, -0.1278, 2024, 3, 20, "06:02", "18:14" },
+		{ "London", "Europe/London", 51.5074, -0.1278, 2024, 6, 20, "04:43", "21:21" },
+		{ "London", "Europe/London", 51.5074, -0.1278, 2024, 12, 21, "08:04", "15:54" },
+		{ "New York", "America/New_York", 40.7128, -74.0060, 2024, 3, 20, "06:59", "19:09" },
+		{ "New York", "America/New_York", 40.7128, -74.0060, 2024, 6, 20, "05:25", "20:31" },
+		{ "New York", "America/New_York", 40.7128, -74.0060, 2024, 12, 21, "07:17", "16:32" },
+		{ "Sydney", "Australia/Sydney", -33.8688, 151.2093, 2024, 3, 20, "06:58", "19:06" },
+		{ "Sydney", "Australia/Sydney", -33.8688, 151.2093, 2024, 6, 20, "07:00", "16:54" },
+		{ "Sydney", "Australia/Sydney", -33.8688, 151.2093, 2024, 12, 21, "05:41", "20:06" },
+		{ "Quito", "America/Guayaquil", -0.1807, -78.4678, 2024, 3, 20, "06:18", "18:24" },
+		{ "Quito", "America/Guayaquil", -0.1807, -78.4678, 2024, 6, 20, "06:12", "18:19" },
+		{ "Quito", "America/Guayaquil", -0.1807, -78.4678, 2024, 12, 21, "06:08", "18:16" },
+		{ "Tokyo", "Asia/Tokyo", 35.6762, 139.6503, 2024, 3, 20, "05:45", "17:53" },
+		{ "Tokyo", "Asia/Tokyo", 35.6762, 139.6503, 2024, 6, 20, "04:26", "19:00" },
+		{ "Tokyo", "Asia/Tokyo", 35.6762, 139.6503, 2024, 12, 21, "06:47", "16:32" },
+		{ "Auckland", "Pacific/Auckland", -36.8485, 174.7633, 2024, 3, 20, "07:24", "19:32" },
+		{ "Auckland", "Pacific/Auckland", -36.8485, 174.7633, 2024, 6, 20, "07:34", "17:12" },
+		{ "Auckland", "Pacific/Auckland", -36.8485, 174.7633, 2024, 12, 21, "05:58", "20:40" },
+		{ "Tromso", "Europe/Oslo", 69.6492, 18.9553, 2024, 3, 20, "05:42", "18:03" },
+		{ "Tromso", "Europe/Oslo", 69.6492, 18.9553, 2024, 6, 20, "", "" },
+		{ "Tromso", "Europe/Oslo", 69.6492, 18.9553, 2024, 12, 21, "", "" },
+		// UTC+14 at 157 W: the local date and the UTC date of its solar noon differ
+		{ "Kiritimati", "Pacific/Kiritimati", 1.8721, -157.4278, 2024, 3, 20, "06:34", "18:40" },
+		{ "Kiritimati", "Pacific/Kiritimati", 1.8721, -157.4278, 2024, 6, 20, "06:24", "18:38" },
+		{ "Kiritimati", "Pacific/Kiritimati", 1.8721, -157.4278, 2024, 12, 21, "06:27", "18:28" }
+};
+
+// Minutes a result may be off: the closed form against the bisection
+static constexpr int toleranceMinutes = 2;
+
+static void setZone(const char* zone)
+{
+	setenv("TZ", zone, 1);
+	tzset();
+}
+
+static time_t localTime(int year, int month, int day, int hour, int minute)
+{
+	struct tm info;
+	memset(&info, 0, sizeof(info));
+	info.tm_year = year - 1900;
+	info.tm_mon = month - 1;
+	info.tm_mday = day;
+	info.tm_hour = hour;
+	info.tm_min = minute;
+	info.tm_isdst = -1;
+	return mktime(&info);
+}
+
+static void checkEvent(const Reference& ref, const char* name, const char* expected, time_t actual)
+{
+	int hour = 0;
+	int minute = 0;
+	sscanf(expected, "%d:%d", &hour, &minute);
+	time_t want = localTime(ref.year, ref.month, ref.day, hour, minute);
+	struct tm info;
+	localtime_r(&actual, &info);
+	long off = (long)(actual - want);
+	CHECK(labs(off) <= toleranceMinutes * 60, "%s %d-%.2d-%.2d %s %.4d-%.2d-%.2d %.2d:%.2d, expected %s",
+			ref.city, ref.year, ref.month, ref.day, name, info.tm_year + 1900, info.tm_mon + 1, info.tm_mday,
+			info.tm_hour, info.tm_min, expected);
+}
+
+static void checkReference(const Reference& ref)
+{
+	setZone(ref.zone);
+	bool polar = !*ref.sunrise;
+	// Any time of the local day gives that day's events
+	static const int hours[] = { 0, 1, 12, 23 };
+	for (int hour : hours) {
+		time_t day = localTime(ref.year, ref.month, ref.day, hour, 30);
+		time_t sunrise = 0;
+		time_t sunset = 0;
+		bool found = SolarCalc::SunEvents(ref.latitude, ref.longitude, day, &sunrise, &sunset);
+		CHECK(found != polar, "%s %d-%.2d-%.2d %.2d:30 %s", ref.city, ref.year, ref.month, ref.day, hour,
+				found ? "has events" : "has no events");
+		if (!found || polar) {
+			continue;
+		}
+		checkEvent(ref, "sunrise", ref.sunrise, sunrise);
+		checkEvent(ref, "sunset", ref.sunset, sunset);
+	}
+}
+
+int main()
+{
+	for (const Reference& ref : References) {
+		checkReference(ref);
+	}
+	return CHECK_RESULT();
+}
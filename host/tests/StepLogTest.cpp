@@ -0,0 +1,101 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "Check.h"
+#include "StepLog.h"
+
+/*
+ * StepLog across a clock that was ahead and then corrected, in memory and
+ * recovered from its file.
+ */
+static const time_t dayStart = 1718841600; // 2024-06-20 00:00 UTC
+static const time_t realNow = dayStart + 8 * 60 * 60;
+// Before the phone synced the watch was a day ahead
+static const time_t clockAhead = 24 * 60 * 60;
+
+// A step a second for the minutes, counter starting at counter
+static int walk(StepLog& log, time_t from, int minutes, int counter)
+{
+	for (int i = 0; i <= minutes; ++i) {
+		log.Append(from + i * 60, counter + i * 60);
+	}
+	return counter + minutes * 60;
+}
+
+static void testClockCorrected(const char* path)
+{
+	StepLog log;
+	CHECK(log.Open(path), "log not opened");
+	log.SetDay(dayStart + clockAhead);
+	int counter = walk(log, realNow + clockAhead, 10, 1000);
+
+	// Synced: the day of the log is today again
+	log.SetDay(dayStart);
+	CHECK(log.TodaySteps() == 0, "%d steps today from the wrong day", log.TodaySteps());
+	counter = walk(log, realNow + 60, 30, counter + 500);
+	CHECK(log.TodaySteps() == 30 * 60, "%d steps after the correction", log.TodaySteps());
+	CHECK(log.HourSteps(8) == 30 * 60, "%d steps in the hour", log.HourSteps(8));
+
+	// A recount doesn't bring back the minutes stamped a day ahead
+	log.SetDay(dayStart);
+	CHECK(log.TodaySteps() == 30 * 60, "%d steps recounted", log.TodaySteps());
+}
+
+static void testClockSetBackToday(const char* path)
+{
+	StepLog log;
+	CHECK(log.Open(path), "log not opened");
+	log.SetDay(dayStart);
+	// An hour ahead, then an hour back: the two walks overlap in minutes
+	int counter = walk(log, realNow + 60 * 60, 10, 0);
+	counter = walk(log, realNow + 20 * 60, 60, counter);
+	CHECK(log.TodaySteps() == 10 * 60 + 60 * 60, "%d steps", log.TodaySteps());
+
+	// Minutes at or past the baseline before it were the clock ahead
+	log.SetDay(dayStart);
+	CHECK(log.TodaySteps() == 60 * 60, "%d steps recounted", log.TodaySteps());
+}
+
+static void testRecovery(const char* path)
+{
+	{
+		StepLog log;
+		CHECK(log.Open(path), "log not opened");
+		log.SetDay(dayStart);
+		int counter = walk(log, realNow + clockAhead, 10, 0);
+		walk(log, realNow, 20, counter);
+	}
+	// The header loses its check, the position comes from the records
+	FILE* file = fopen(path, "r+b");
+	CHECK(file != nullptr, "no log file");
+	if (file) {
+		uint32_t head = 0;
+		fseek(file, 3 * sizeof(uint32_t), SEEK_SET);
+		fwrite(&head, sizeof(head), 1, file);
+		fclose(file);
+	}
+	StepLog log;
+	CHECK(log.Open(path), "log not reopened");
+	log.SetDay(dayStart);
+	CHECK(log.TodaySteps() == 20 * 60, "%d steps recovered", log.TodaySteps());
+	log.Append(realNow + 21 * 60, 10 * 60 + 21 * 60);
+	CHECK(log.TodaySteps() == 21 * 60, "%d steps appended after recovery", log.TodaySteps());
+}
+
+int main()
+{
+	testClockCorrected(nullptr);
+	testClockSetBackToday(nullptr);
+
+	char path[PATH_MAX];
+	const char* dir = getenv("TMPDIR");
+	snprintf(path, sizeof(path), "%s/omahawatch_steplog_XXXXXX", dir && dir[0] ? dir : "/tmp");
+	int fd = mkstemp(path);
+	CHECK(fd >= 0, "no temporary file %s", path);
+	close(fd);
+	unlink(path);
+	testRecovery(path);
+	unlink(path);
+	return CHECK_RESULT();
+}
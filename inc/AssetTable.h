@@ -0,0 +1,36 @@
+#ifndef _ASSETTABLE_H_
+#define _ASSETTABLE_H_
+
+/*
+ * The image files in use by the face, one entry per file. Themes that name
+ * the same file share its entry, so switching between them leaves those
+ * images on their objects, and Evas keeps a single decoded copy. Entries
+ * are counted per user and their slot is reused once nobody needs them.
+ */
+class AssetTable
+{
+public:
+	static constexpr int maxAssets = 32;
+	static constexpr int maxFile = 256;
+
+	AssetTable();
+
+	// Returns the entry for the file, -1 if the table is full or the path too long
+	int Acquire(const char* file);
+	// Another user of an acquired entry
+	void Retain(int asset);
+	void Release(int asset);
+	const char* File(int asset) const { return entries_[asset].file; }
+	// Entries in use
+	int Size() const;
+private:
+	struct Entry
+	{
+		char file[maxFile];
+		int users;
+	};
+
+	Entry entries_[maxAssets];
+};
+
+#endif
@@ -2,11 +2,18 @@
 #define CURLWRAPPER_H_
 #include <stdio.h>
 #include <string>
+#include "WorkerPool.h"
 
 class CurlWrapper {
 public:
+	// Bits of err on top of the curl code
+	static constexpr int errorProxy = 1 << 14;         // with the platform error
+	static constexpr int errorProxyTimedOut = 1 << 13; // retried without the proxy
+
 	void Test();
-	static std::string Get(const std::string& url, int& err, bool useProxy = true);
+	// Blocking, call from a worker. Aborts early once the token is cancelled.
+	// The proxy is read by the caller on the main thread, empty - direct.
+	static std::string Get(const std::string& url, int& err, const CancelToken* cancel = nullptr, const std::string& proxy = std::string());
 private:
 
 };
@@ -0,0 +1,71 @@
+#ifndef _DATASOURCES_H_
+#define _DATASOURCES_H_
+#include <time.h>
+#include <stdint.h>
+
+/*
+ * Registry of the things the face shows. Each source declares how often it
+ * changes (cadence), how old it may get before it is refreshed regardless
+ * (staleness) and the layout parts it owns. A tick refreshes only the due
+ * sources, and a source only redraws its own parts, so a new complication
+ * doesn't add work to the others' path.
+ */
+class DataSources
+{
+public:
+	typedef void (*RefreshCallback)(time_t now, void* data);
+
+	static constexpr int maxSources = 8;
+	static constexpr int maxParts = 4;
+
+	struct Definition
+	{
+		const char* name;
+		// Refreshed whenever now crosses a multiple of cadence seconds,
+		// 0 - only on Push
+		int cadence;
+		// Seconds since the last refresh, 0 - no limit
+		int staleness;
+		// Owned layout parts, unused entries are nullptr
+		const char* parts[maxParts];
+	};
+
+	DataSources();
+
+	// Returns the source id or -1 if the table is full. The definition has
+	// to outlive the registry.
+	int Register(const Definition* definition, RefreshCallback cb, void* data);
+	// The source has new data, it's refreshed on the next Tick
+	void Push(int source);
+	// The part needs a redraw, e.g. after the layout was reloaded
+	void InvalidatePart(const char* part);
+	void InvalidateAll();
+	// Refreshes the due sources, returns how many
+	int Tick(time_t now);
+	// Refreshes right away, for pushes that shouldn't wait for a tick
+	void Refresh(int source, time_t now);
+
+	int Size() const { return sourcesNum_; }
+	const char* Name(int source) const { return sources_[source].definition->name; }
+	uint32_t Refreshes(int source) const { return sources_[source].refreshes; }
+	// Name of the source owning the part, nullptr if none
+	const char* Owner(const char* part) const;
+private:
+	struct Source
+	{
+		const Definition* definition;
+		RefreshCallback cb;
+		void* data;
+		time_t refreshed; // 0 - never
+		bool pushed;
+		uint32_t refreshes;
+	};
+
+	bool due(const Source& source, time_t now) const;
+	int findOwner(const char* part) const;
+
+	Source sources_[maxSources];
+	int sourcesNum_;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef _DAYPLAN_H_
+#define _DAYPLAN_H_
+#include <time.h>
+
+/*
+ * Sun events of the current day and their positions on the dial.
+ * Built once per weather update and rolled over to the next day when the
+ * last event has passed, so a tick only has to look at the next event.
+ * Countdowns are taken from absolute timestamps and are not affected by
+ * midnight or DST changes.
+ */
+class DayPlan
+{
+public:
+	enum EventType {
+		EVENT_SUNRISE,
+		EVENT_SUNSET
+	};
+
+	struct Event
+	{
+		time_t time;
+		EventType type;
+	};
+
+	// Top left corner of a sun icon, in base dial coordinates
+	struct Marker
+	{
+		int x;
+		int y;
+	};
+
+	DayPlan();
+
+	void Build(time_t sunrise, time_t sunset, time_t now);
+	bool Ready() const { return ready_; }
+
+	// Skips elapsed events. Returns true if the plan rolled over to the next
+	// day and the markers have moved.
+	bool Advance(time_t now);
+	const Event& Next() const { return events_[next_]; }
+	int MinutesUntilNext(time_t now) const;
+
+	const Marker& SunriseMarker() const { return sunriseMarker_; }
+	const Marker& SunsetMarker() const { return sunsetMarker_; }
+private:
+	void rollOver(time_t now);
+	static Marker markerFor(time_t time);
+
+	static constexpr int eventsNum = 2;
+	Event events_[eventsNum];
+	int next_;
+	Marker sunriseMarker_;
+	Marker sunsetMarker_;
+	bool ready_;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef _DIAGNOSTICS_H_
+#define _DIAGNOSTICS_H_
+#include <Elementary.h>
+
+class Diagnostics
+{
+public:
+	// Resident set size of the process in kB, -1 if unavailable
+	static int ResidentKb();
+	// Number of Evas objects on the canvas, smart object members included
+	static int ObjectCount(Evas* evas);
+	static void LogScene(const char* stage, Evas* evas);
+private:
+	static int countObject(Evas_Object* obj);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _DISPLAY_H_
+#define _DISPLAY_H_
+#include <stddef.h>
+
+/*
+ * Dial geometry for the screen the face runs on. The layout is designed in
+ * BASE_WIDTH x BASE_HEIGHT coordinates; at startup the face picks the
+ * pre-scaled asset set matching the dial size, and every position and size
+ * is converted through here so the images are drawn 1:1. A screen without
+ * its own set falls back to the base images, scaled by Evas.
+ */
+class Display
+{
+public:
+	struct Resolution
+	{
+		int size;           // dial edge in pixels
+		const char* images; // resource directory of the set
+	};
+
+	// Returns true if the set's images are installed
+	typedef bool (*AvailableCallback)(const char* images);
+
+	Display();
+
+	void Select(int width, int height, AvailableCallback available);
+
+	// false - images are scaled on every draw
+	bool Native() const { return native_; }
+	int Size() const { return size_; }
+	int Left() const { return left_; }
+	int Top() const { return top_; }
+	const char* Images() const { return set_->images; }
+
+	// Base coordinates to screen pixels
+	int Scale(int base) const;
+	int X(int base) const { return left_ + Scale(base); }
+	int Y(int base) const { return top_ + Scale(base); }
+
+	// Maps an "images/..." resource to the selected set
+	const char* ImagePath(const char* path, char* out, size_t len) const;
+private:
+	const Resolution* set_;
+	int size_;
+	int left_;
+	int top_;
+	bool native_;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef _EVENTRING_H_
+#define _EVENTRING_H_
+#include <stdint.h>
+
+/*
+ * Fixed ring of binary event records for the debug overlay and exports.
+ * Adding a record is a handful of stores; text is only produced when the
+ * ring is read.
+ */
+class EventRing
+{
+public:
+	enum Event {
+		EVENT_WEATHER_REQUEST,
+		EVENT_CURL_FAILED,
+		EVENT_CURL_WARNING,
+		EVENT_JSON_ERROR,
+		EVENT_WEATHER_TIMER,
+		EVENT_POWER_TIER,
+		EVENT_LOCATION_STATE,
+		EVENT_LOCATION_FAILED,
+		EVENT_LOCATION_METHOD,
+		EVENT_LOCATION_START_FAILED,
+		EVENT_LOCATION_STOP_FAILED,
+		EVENT_TIMER_FAILED,
+		EVENT_BATTERY,
+		EVENT_CONNECTIVITY,
+		EVENT_TIME_CHANGED,
+		EVENT_AMBIENT_LATENCY,
+		EVENT_QUIET,
+		EVENT_REFRESH,
+		EVENT_PRE_WAKE,
+		EVENTS_NUM
+	};
+
+	static constexpr int capacity = 64;
+
+	EventRing();
+
+	void Add(Event event, int arg0 = 0, int arg1 = 0);
+	int Size() const;
+	// Records ever added, tells readers whether anything changed
+	uint32_t Sequence() const { return written_; }
+
+	// index 0 is the oldest record
+	void Get(int index, Event* event, int* arg0, int* arg1) const;
+	// index 0 is the oldest record. Returns the length like snprintf.
+	int Format(int index, char* str, int len) const;
+	// The newest records, oldest first, each followed by separator
+	void FormatLast(int records, const char* separator, char* str, int len) const;
+	// Writes every record to the debug log
+	void Log() const;
+private:
+	struct Record
+	{
+		uint32_t time;
+		uint16_t event;
+		uint16_t reserved;
+		int32_t args[2];
+	};
+
+	Record records_[capacity];
+	uint32_t written_;
+};
+
+#endif
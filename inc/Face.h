@@ -7,75 +7,113 @@
 #include <watch_app_efl.h>
 #include <app.h>
 #include <dlog.h>
-#include <device/battery.h>
 #include <omahawatch.h>
-#include <sensor.h>
-#include <locations.h>
-#include "Timer.h"
-#include <list>
 #include <string>
-#include "WeatherInfo.h"
+#include "FaceController.h"
+#include "FaceView.h"
+#include "TextPart.h"
+#include "MemoryPressure.h"
+#include "Display.h"
+#include "Theme.h"
+#include "AssetTable.h"
 using namespace std;
 
-class Face {
+/*
+ * The Evas side of the watch face. What is shown when is decided by
+ * FaceController, Face draws it.
+ */
+class Face: public FaceView {
 public:
 	Face(int width, int height);
 	~Face();
 
 	bool Init();
 	void Tick(watch_time_h time);
-	bool ToggleAmbient(bool ambient);
+	void ToggleAmbient(bool ambient);
 	void PauseAnimator();
 	void ResumeAnimator();
+	void LowBattery();
+	void LowMemory(app_event_low_memory_status_e status);
+	// Switches to an installed theme pack and keeps it for the next start
+	bool SetTheme(const char* name);
+	// Sets the quiet hours, see QuietMode::ParseSchedule, and keeps them for the next start
+	bool SetQuietSchedule(const char* text);
+
+	// FaceView
+	void SetText(Text text, const char* value) override;
+	void SetIcon(Icon icon, const char* file) override;
+	void PlaceSunIcons(const DayPlan& plan) override;
+	bool MoveHands(const HandAngles& angles) override;
+	void ShowSecondHand(bool shown) override;
+	void SetAnimating(bool animating) override;
 private:
+	// An image of the theme, decoded when its object is first shown
+	struct ThemedImage
+	{
+		Evas_Object* object;
+		int wanted; // AssetTable entry of the theme, -1 - none
+		int shown;  // entry set on the object, -1 - none
+		bool loaded;
+	};
+
 	bool createWindow();
+	static bool imagesAvailable(const char* images);
 	bool createBg();
 	bool createLayout();
+	bool loadLayout();
 	bool createSublayoutParts();
 	bool createParts();
-	Evas_Object* createPart(const char* path, int x, int y, int width, int height);
-	bool setupListeners();
-	bool setupLocation();
-
-	bool setBg();
+	Evas_Object* createPart(const char* path, int x, int y, int width, int height, bool async = false);
+	Evas_Object* createThemedPart(Theme::Asset asset);
+	void placeParts();
+	void placeHand(Evas_Object* hand, Evas_Object* shadow, Theme::Hand geometry);
+	bool setImageFile(Evas_Object* image, const char* path, bool async = false);
+	bool loadImage(Evas_Object* image, const char* file, bool async);
+	bool findTheme(const char* name, Theme* theme, char* dir, size_t len);
+	void selectTheme();
+	void loadQuietSchedule();
+	void themeFile(const char* file, char* out, size_t len);
+	void wantAssets();
+	bool loadAsset(Theme::Asset asset);
+	void dropAsset(Theme::Asset asset);
+	void invalidateTexts();
+	void openTrace();
+
+	static void renderPostCallback(void *data, Evas *e, void *eventInfo);
+	void watchRenderPost();
+	void onRenderPost();
+	void onFirstFrame();
+	void onAmbientFrame();
+	static Eina_Bool startupIdlerCallback(void *data);
+	void onStartupIdler();
+
+	void showBg();
 
 	static Eina_Bool animatorCallback(void *data);
-	bool onAnimator();
-
-	static void listenerCallback(sensor_h sensorHanlder, sensor_event_s* event, void* data);
-	void onListener(sensor_h sensorHanlder, sensor_event_s* event);
-
-	static void locationStateCallback(location_service_state_e state, void *data);
-	void onLocationState(location_service_state_e state);
 
 	static void weatherClickCallback(void *data, Evas *e, Evas_Object *obj, void *eventInfo);
 	void onWeatherClick();
 
-	void moveHands(watch_time_h time);
 	void rotateHand(Evas_Object *hand, double degree, Evas_Coord cx, Evas_Coord cy);
 
-	void updateTextFields();
-	void updateTextField(const char* fieldId, int value);
-
-	void updateDate(watch_time_h time);
-
-	static bool weatherTimerFunc(void* data);
-	void onWeatherTimer();
-
-	static bool LocationTimeoutCallback(void* data);
-	void onLocationTimeout();
-
-	int updateLocation();
-	void updateWeather();
-	void updateWeatherText();
-
-	bool requestLocationServiceState(location_service_state_e state);
-
-	void setLastError(const char* fmt, ...);
-	void moveSunIcon(Evas_Object* icon, time_t time);
+	// Memory pressure, see registerMemoryReleasers
+	template<void (Face::*Release)()>
+	static void memoryCallback(void* data)
+	{
+		(((Face*)data)->*Release)();
+	}
+	void registerMemoryReleasers();
+	void releaseCaches();
+	void restoreCaches();
+	void releaseSprites();
+	void releaseBg();
+	void releaseTables();
+	void releaseWorkers();
 
 	Evas_Object* window_;
 	Evas_Object* bg_;
+	// Both stay decoded so the ambient switch only swaps visibility
+	Evas_Object* bgAmbient_;
 	Evas_Object* layout_;
 	Evas_Object* handSec_;
 	Evas_Object* handMin_;
@@ -83,35 +121,48 @@ private:
 	Evas_Object* handsSecShadow_;
 	Evas_Object* handMinShadow_;
 	Evas_Object* handHourShadow_;
+	Evas_Map* handMap_;
 	Evas_Object* weatherIcon_;
 	Evas_Object* batteryIcon_;
 	Evas_Object* sunsetIcon_;
 	Evas_Object* sunriseIcon_;
+	Evas_Object* weatherHitArea_;
 	Ecore_Animator *animator_;
-	Timer::TimerHandle weatherTimer_;
-	Timer::TimerHandle locationTimeoutTimer_;
-
-	location_manager_h locationManager_;
-	WeatherInfo* weather_;
+	Ecore_Idler *startupIdler_;
+	bool renderPostWatched_;
+	bool waitingFirstFrame_;
+	// ecore_time_get() of the last ambient change until its frame is out, 0 - none
+	double ambientChangeTime_;
+	double initStartTime_;
 
 	int width_;
 	int height_;
+	Display display_;
+	Theme theme_;
+	// Directory of the theme pack, empty - built-in look
+	char themeDir_[PATH_MAX];
+	AssetTable assets_;
+	ThemedImage themed_[Theme::ASSETS_NUM];
 
-	sensor_listener_h listener_;
 	bool ambient_;
-
-	int steps_;
-
-	int lastSteps_;
-
-	int lastTickDay_;
-	int lastTickMinute_;
-	double longitude_;
-	double latitude_;
-
-	int locationState_;
-	int locationStateRequested_;
-	list<string> errors_;
+	double hourDegree_;
+	double minDegree_;
+	double secDegree_;
+
+	MemoryPressure memory_;
+	int imageCacheSize_;
+
+	TextPart dateText_;
+	TextPart eventText_;
+	TextPart countdownText_;
+	TextPart weatherText_;
+	TextPart weatherTempText_;
+	TextPart batteryText_;
+	TextPart stepsText_;
+	TextPart moonText_;
+
+	// Draws through this Face, see FaceView
+	FaceController controller_;
 };
 
 #endif /* FACE_H_ */
@@ -0,0 +1,186 @@
+#ifndef _FACECONTROLLER_H_
+#define _FACECONTROLLER_H_
+#include <time.h>
+#include "DataSources.h"
+#include "DayPlan.h"
+#include "EventRing.h"
+#include "FaceView.h"
+#include "LocationScheduler.h"
+#include "Platform.h"
+#include "PowerGovernor.h"
+#include "QuietMode.h"
+#include "RefreshPipeline.h"
+#include "SensorHub.h"
+#include "Stats.h"
+#include "StepLog.h"
+#include "Timer.h"
+#include "Trace.h"
+#include "WeatherInfo.h"
+#include "WorkerPool.h"
+
+/*
+ * Everything the face decides, without Evas: power and quiet policy, the
+ * weather timer and refresh pipeline, location and network, sensors, the
+ * step log and the data sources. What it shows goes to a FaceView. Face
+ * runs it on the watch and the host simulator runs the same code on a
+ * virtual clock, so a schedule change shows up in both.
+ */
+class FaceController
+{
+public:
+	explicit FaceController(FaceView* view);
+	~FaceController();
+
+	// Records the inputs from here on, see Trace
+	bool OpenTrace(const char* path);
+	// Starts following battery, network and time changes
+	void Init();
+	// Sensors and location are brought up once the face is on screen.
+	// stepLogPath nullptr - the step history is kept in memory only.
+	bool SetupSensors(const char* stepLogPath);
+	bool SetupLocation();
+
+	// Time tick while visible, ambient tick once a minute
+	void Tick(time_t now, int msec);
+	// Animator frame. Returns false if no hand has moved.
+	bool Frame();
+	void Pause();
+	void Resume();
+	void SetAmbient(bool ambient);
+	void LowBattery();
+	void SetQuietSchedule(const QuietMode::Schedule& schedule);
+	void ToggleWeatherScale();
+	// Weather request address without the query, has to outlive the controller
+	void SetWeatherUrl(const char* url) { weatherUrl_ = url; }
+	// The layout was loaded again and has the texts of its edc
+	void InvalidateAll() { sources_.InvalidateAll(); }
+	void TrimTables() { stepLog_.Trim(); }
+
+	const DayPlan& GetDayPlan() const { return dayPlan_; }
+	EventRing& Events() { return events_; }
+	PowerGovernor::Tier GetTier() const { return governor_.GetTier(); }
+	bool Quiet() const { return quietMode_.Quiet(); }
+private:
+	void traceSteps();
+	bool createLocationManager(LocationScheduler::Method method);
+	void destroyLocationManager();
+	int stepCounter();
+
+	static void batteryChangedCallback(void* data);
+	static void connectivityChangedCallback(void* data);
+	static void timeChangedCallback(void* data);
+	bool readBattery();
+	void onConnectivityChanged();
+	void onTimeChanged();
+
+	void updatePower();
+	void applyPowerPolicy();
+	void updateQuiet(time_t now);
+	void applyQuietMode(time_t now);
+	void updateAnimatorState();
+	void updateSecondHand();
+	void updateSensorPolicy();
+	void scheduleWeatherTimer();
+	bool moveHands(const struct tm& timeInfo, int msec);
+
+	static void locationStateCallback(LocationSource::State state, void *data);
+	void onLocationState(LocationSource::State state);
+
+	// Data sources, see registerSources
+	template<void (FaceController::*Refresh)(time_t)>
+	static void sourceCallback(time_t now, void* data)
+	{
+		(((FaceController*)data)->*Refresh)(now);
+	}
+	void registerSources();
+	void updateBattery(time_t now);
+	void updateStepLog(time_t now);
+	void updateSteps(time_t now);
+	void updateDate(time_t now);
+	void updateSunEvent(time_t now);
+	void updateWeatherText(time_t now);
+	void updateEventOverlay(time_t now);
+	void updateTextField(FaceView::Text text, int value);
+
+	static bool weatherTimerFunc(void* data);
+	void onWeatherTimer();
+	void retryMissedRefresh();
+
+	// Refresh stages, see RefreshPipeline
+	static bool locationStartCallback(void* data);
+	static void locationStopCallback(bool completed, void* data);
+	static bool fetchStartCallback(void* data);
+	static void fetchStopCallback(bool completed, void* data);
+	static void refreshDeadlineCallback(int seconds, void* data);
+	static void refreshExpiredCallback(void* data);
+	static void refreshFinishedCallback(RefreshPipeline::Stage stage, RefreshPipeline::Outcome outcome, void* data);
+	bool startLocation();
+	void stopLocation();
+	bool startFetch();
+	void onRefreshFinished(RefreshPipeline::Stage stage, RefreshPipeline::Outcome outcome);
+
+	bool updateLocation();
+	struct WeatherFetch;
+	void onWeatherFetched(const WeatherFetch& fetch);
+	void updateDayPlan(time_t now);
+
+	FaceView* view_;
+
+	Timer::TimerHandle weatherTimer_;
+	int weatherInterval_;
+	// SetupLocation has run, the weather timer follows the policy from then on
+	bool weatherStarted_;
+	RefreshPipeline refresh_;
+	MainLoop::Timeout* refreshDeadline_;
+
+	LocationSource* location_;
+	LocationScheduler::Method locationMethod_;
+	LocationScheduler locationScheduler_;
+	WeatherInfo weather_;
+	const char* weatherUrl_;
+	CancelToken weatherToken_;
+	// Clock::Monotonic() when the fetch was sent
+	double fetchStartTime_;
+	DayPlan dayPlan_;
+
+	SensorHub sensorHub_;
+	StepLog stepLog_;
+	bool ambient_;
+	bool paused_;
+
+	PowerGovernor governor_;
+	QuietMode quietMode_;
+	// Battery level when the face went quiet
+	int quietBattery_;
+
+	int batteryPercent_;
+	bool charging_;
+	bool online_;
+	// A weather refresh was skipped or cancelled, made up for once possible
+	bool weatherMissed_;
+
+	int batteryIconLevel_;
+	char weatherIconFile_[64];
+	Stats::Snapshot stats_;
+	int lastTickDay_;
+	double longitude_;
+	double latitude_;
+	bool hasLocation_;
+
+	EventRing events_;
+	uint32_t eventsShown_;
+	Trace trace_;
+	int tracedSteps_;
+
+	DataSources sources_;
+	int batterySource_;
+	int stepLogSource_;
+	int quietSource_;
+	int stepsSource_;
+	int dateSource_;
+	int sunSource_;
+	int weatherSource_;
+	int eventsSource_;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _FACEVIEW_H_
+#define _FACEVIEW_H_
+#include "DayPlan.h"
+#include "HandAngles.h"
+
+/*
+ * What FaceController puts on the dial. Face draws it with Evas, the host
+ * simulator keeps what it needs for the report. Main thread; strings are
+ * only valid during the call.
+ */
+class FaceView
+{
+public:
+	enum Text {
+		TEXT_DATE,
+		TEXT_MOON,
+		TEXT_EVENT,
+		TEXT_COUNTDOWN,
+		TEXT_WEATHER,
+		TEXT_WEATHER_TEMP,
+		TEXT_BATTERY,
+		TEXT_STEPS,
+		TEXT_EVENTS, // debug overlay
+		TEXTS_NUM
+	};
+
+	enum Icon {
+		ICON_WEATHER,
+		ICON_BATTERY,
+		ICONS_NUM
+	};
+
+	virtual ~FaceView() {}
+	virtual void SetText(Text text, const char* value) = 0;
+	// An image of the app's resources, only called when it changes
+	virtual void SetIcon(Icon icon, const char* file) = 0;
+	// Hidden if the plan isn't ready
+	virtual void PlaceSunIcons(const DayPlan& plan) = 0;
+	// Returns false if no hand has moved since the last call
+	virtual bool MoveHands(const HandAngles& angles) = 0;
+	virtual void ShowSecondHand(bool shown) = 0;
+	// The smooth second hand needs animator frames, see FaceController::Frame
+	virtual void SetAnimating(bool animating) = 0;
+};
+
+#endif
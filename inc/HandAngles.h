@@ -0,0 +1,19 @@
+#ifndef _HANDANGLES_H_
+#define _HANDANGLES_H_
+#include "PowerGovernor.h"
+
+/*
+ * Hand positions in degrees for a time of day. Kept apart from Face so the
+ * host simulator runs the same per-frame arithmetic.
+ */
+struct HandAngles
+{
+	double hour;
+	double minute;
+	double second;
+	bool secondShown;
+
+	static HandAngles At(int hour, int minute, int second, int msec, PowerGovernor::SecondHand secondHand, bool ambient);
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef _LOCATIONSCHEDULER_H_
+#define _LOCATIONSCHEDULER_H_
+#include <time.h>
+
+/*
+ * Decides whether the weather refresh needs a new location fix or can
+ * reuse the last one, based on its age and on how much the wearer walked
+ * since. Also tracks how long the location service was on.
+ */
+class LocationScheduler
+{
+public:
+	enum Method {
+		METHOD_WPS,
+		METHOD_HYBRID
+	};
+
+	LocationScheduler();
+
+	// stepCounter is the raw pedometer counter, -1 if unknown
+	void OnFix(time_t time, int stepCounter);
+	// Acquisition timed out. Next attempt uses a more capable method.
+	void OnTimeout();
+	bool NeedsFix(time_t now, int stepCounter) const;
+	bool HasFix() const { return fixTime_ != 0; }
+	time_t FixTime() const { return fixTime_; }
+	Method GetMethod() const { return method_; }
+
+	void ServiceOn(time_t now);
+	void ServiceOff(time_t now);
+	// True once an hour, with the seconds the service was on during it
+	bool HourlyReport(time_t now, int* onSeconds);
+private:
+	time_t fixTime_;
+	int fixCounter_;
+	Method method_;
+
+	time_t onSince_;
+	time_t hourStart_;
+	int onSeconds_;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef _LOG_H_
+#define _LOG_H_
+#include "Platform.h"
+
+/*
+ * Logging facade. Levels above LOG_LEVEL compile to nothing, arguments
+ * included, so release builds don't pay for debug and verbose logs.
+ */
+#define LOG_LEVEL_NONE    0
+#define LOG_LEVEL_ERROR   1
+#define LOG_LEVEL_WARN    2
+#define LOG_LEVEL_INFO    3
+#define LOG_LEVEL_DEBUG   4
+#define LOG_LEVEL_VERBOSE 5
+
+#ifndef LOG_LEVEL
+#ifdef _DEBUG
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(...) platform_log(Logger::LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_E(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(...) platform_log(Logger::LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_W(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(...) platform_log(Logger::LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_I(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(...) platform_log(Logger::LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_D(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_VERBOSE
+#define LOG_V(...) platform_log(Logger::LEVEL_VERBOSE, __VA_ARGS__)
+#else
+#define LOG_V(...) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef _MEMORYPRESSURE_H_
+#define _MEMORYPRESSURE_H_
+
+/*
+ * Answers low memory warnings by releasing resources in tiers, cheapest to
+ * rebuild first, instead of closing the face. Owners register what they can
+ * drop and rebuild it lazily on their own the next time it's needed; the
+ * optional restore callback only undoes limits set while under pressure.
+ */
+class MemoryPressure
+{
+public:
+	enum Tier {
+		TIER_NONE,
+		TIER_CACHES,  // decoded image, font and edje caches
+		TIER_SPRITES, // images that aren't on screen
+		TIER_TABLES,  // history tables that can be read back from disk
+		TIER_NETWORK, // idle workers and their heap
+		TIERS_NUM
+	};
+
+	typedef void (*Callback)(void* data);
+
+	static constexpr int maxEntries = 8;
+
+	MemoryPressure();
+
+	bool Register(Tier tier, const char* name, Callback release, Callback restore, void* data);
+	// Releases every tier up to and including tier that isn't released yet.
+	// Resident memory is logged before and after each one.
+	void Raise(Tier tier);
+	// Pressure is over, released tiers are released again on the next Raise
+	void Relieve();
+	Tier Current() const { return current_; }
+	static const char* TierName(Tier tier);
+private:
+	struct Entry
+	{
+		Tier tier;
+		const char* name;
+		Callback release;
+		Callback restore;
+		void* data;
+	};
+
+	Entry entries_[maxEntries];
+	int entriesNum_;
+	Tier current_;
+};
+
+#endif
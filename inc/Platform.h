@@ -0,0 +1,154 @@
+#ifndef _PLATFORM_H_
+#define _PLATFORM_H_
+#include <time.h>
+#include <string>
+#include "LocationScheduler.h"
+
+/*
+ * Thin interfaces over the device services the logic depends on. The watch
+ * installs the Tizen implementations (TizenPlatform), the host build its own
+ * (host/HostPlatform) so the same code runs on an ordinary Linux box.
+ */
+
+class Clock
+{
+public:
+	typedef void (*ChangedCallback)(void* data);
+
+	virtual ~Clock() {}
+	// Unix time, seconds
+	virtual double Now() = 0;
+	// Seconds from an arbitrary point, never jumps and keeps counting
+	// while the device is suspended
+	virtual double Monotonic() = 0;
+	// Main thread, when the time is set or the time zone changes. The new
+	// zone is in effect for localtime_r by then. A null cb unsubscribes.
+	virtual void SetChangedCallback(ChangedCallback cb, void* data) = 0;
+};
+
+class Logger
+{
+public:
+	enum Level {
+		LEVEL_VERBOSE,
+		LEVEL_DEBUG,
+		LEVEL_INFO,
+		LEVEL_WARN,
+		LEVEL_ERROR
+	};
+
+	virtual ~Logger() {}
+	virtual void Write(Level level, const char* msg) = 0;
+};
+
+class SensorDevice
+{
+public:
+	// May be called on a sensor thread
+	typedef void (*EventCallback)(float value, void* data);
+
+	virtual ~SensorDevice() {}
+	virtual bool Start() = 0;
+	virtual void Stop() = 0;
+	// A null callback stops event delivery, the sensor keeps running
+	virtual void SetCallback(int interval, int batchLatency, EventCallback cb, void* data) = 0;
+	virtual bool Read(float* value) = 0;
+};
+
+class Sensors
+{
+public:
+	enum Kind {
+		KIND_PEDOMETER,
+		KIND_HEART_RATE,
+		KIND_PRESSURE
+	};
+
+	virtual ~Sensors() {}
+	// Returns a started sensor owned by the caller or nullptr
+	virtual SensorDevice* Open(Kind kind) = 0;
+};
+
+class LocationSource
+{
+public:
+	enum State {
+		STATE_DISABLED,
+		STATE_ENABLED
+	};
+
+	typedef void (*StateCallback)(State state, void* data);
+
+	virtual ~LocationSource() {}
+	virtual bool Open(LocationScheduler::Method method, StateCallback cb, void* data) = 0;
+	virtual void Close() = 0;
+	virtual bool IsOpen() = 0;
+	// Asynchronous, the state callback reports the result
+	virtual bool Start() = 0;
+	virtual bool Stop() = 0;
+	virtual bool Position(double* latitude, double* longitude, time_t* timestamp) = 0;
+	virtual bool LastPosition(double* latitude, double* longitude, time_t* timestamp) = 0;
+};
+
+class Battery
+{
+public:
+	typedef void (*ChangedCallback)(void* data);
+
+	virtual ~Battery() {}
+	virtual bool Percent(int* percent) = 0;
+	virtual bool Charging(bool* charging) = 0;
+	// Main thread, when the capacity or the charging state changes.
+	// A null cb unsubscribes.
+	virtual void SetChangedCallback(ChangedCallback cb, void* data) = 0;
+};
+
+class Connectivity
+{
+public:
+	typedef void (*ChangedCallback)(void* data);
+
+	virtual ~Connectivity() {}
+	virtual bool Online() = 0;
+	// Main thread, when the connection type changes. A null cb unsubscribes.
+	virtual void SetChangedCallback(ChangedCallback cb, void* data) = 0;
+	// Main thread, like the rest of the interface; workers get the result.
+	// 0 on success, platform error code otherwise. Empty proxy - direct connection
+	virtual int Proxy(std::string& proxy) = 0;
+};
+
+class MainLoop
+{
+public:
+	typedef void (*Callback)(void* data);
+	// One-shot timer, defined by each platform
+	struct Timeout;
+
+	virtual ~MainLoop() {}
+	// Any thread, cb runs on the main thread
+	virtual void Post(Callback cb, void* data) = 0;
+	// Main thread. Runs cb once after seconds, also while the face is paused.
+	// Returns nullptr if the timer couldn't be added.
+	virtual Timeout* AddTimeout(double seconds, Callback cb, void* data) = 0;
+	// Only for a timeout that hasn't run yet
+	virtual void DeleteTimeout(Timeout* timeout) = 0;
+};
+
+struct Platform
+{
+	Clock* clock;
+	Logger* logger;
+	Sensors* sensors;
+	LocationSource* location;
+	Battery* battery;
+	Connectivity* connectivity;
+	MainLoop* mainLoop;
+
+	static Platform& Get();
+	// Must be called before any of the services is used
+	static void Install(const Platform& platform);
+};
+
+void platform_log(Logger::Level level, const char* fmt, ...);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _POWERGOVERNOR_H_
+#define _POWERGOVERNOR_H_
+
+/*
+ * Picks how much the face is allowed to spend based on battery level and
+ * charging state. Tier changes use separate enter/leave thresholds so the
+ * face doesn't flap around a single battery percentage.
+ */
+class PowerGovernor
+{
+public:
+	enum Tier {
+		TIER_FULL,
+		TIER_SAVER,
+		TIER_CRITICAL
+	};
+
+	enum SecondHand {
+		SECOND_HAND_SMOOTH,
+		SECOND_HAND_TICK,
+		SECOND_HAND_OFF
+	};
+
+	struct Policy
+	{
+		SecondHand secondHand;
+		int weatherInterval;   // seconds, 0 - weather updates paused
+		bool locationEnabled;  // false - use the last known position only
+		int pedometerInterval; // ms, 0 - read once on the minute tick
+	};
+
+	PowerGovernor();
+
+	// Both return true if the tier has changed
+	bool Update(int batteryPercent, bool charging);
+	bool LowBattery();
+
+	Tier GetTier() const { return tier_; }
+	const Policy& GetPolicy() const;
+	static const char* TierName(Tier tier);
+private:
+	Tier tier_;
+	bool lowBattery_;
+};
+
+#endif
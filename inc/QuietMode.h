@@ -0,0 +1,61 @@
+#ifndef _QUIETMODE_H_
+#define _QUIETMODE_H_
+#include <stddef.h>
+#include <time.h>
+
+/*
+ * Tells when the wearer is most likely asleep: inside the scheduled quiet
+ * window and no steps for a while. The face suspends network, location
+ * and sensor wakeups while quiet, apart from one refresh shortly before
+ * the window ends so the morning glance shows fresh weather.
+ */
+class QuietMode
+{
+public:
+	struct Schedule
+	{
+		int start;      // minute of the day, may be after end
+		int end;
+		int inactivity; // minutes without steps before going quiet
+		int preWake;    // minutes before end of the refresh, 0 - none
+	};
+
+	static Schedule DefaultSchedule();
+	// start == end, never quiet
+	static Schedule NoSchedule();
+	// "HH:MM-HH:MM [inactivity [pre-wake]]" or "off", the minutes default to
+	// the default schedule's. Returns false and leaves schedule alone on bad text.
+	static bool ParseSchedule(const char* text, Schedule* schedule);
+	static void FormatSchedule(const Schedule& schedule, char* out, size_t len);
+
+	QuietMode();
+
+	void SetSchedule(const Schedule& schedule);
+	const Schedule& GetSchedule() const { return schedule_; }
+
+	// stepCounter is the raw pedometer counter, -1 if unknown. Returns true
+	// if Quiet() has changed.
+	bool Update(time_t now, int stepCounter);
+	bool Quiet() const { return quiet_; }
+	time_t QuietSince() const { return quietSince_; }
+
+	// True once a night, when the pre-wake refresh is due
+	bool PreWakeDue(time_t now);
+private:
+	bool inWindow(time_t now) const;
+	time_t windowEnd(time_t now) const;
+	void noteSteps(time_t now, int stepCounter);
+
+	Schedule schedule_;
+	bool quiet_;
+	time_t quietSince_;
+	time_t windowEnd_;
+	time_t preWakeDone_;
+
+	// Steps are counted over inactivity long periods
+	time_t lastActive_;
+	time_t periodStart_;
+	int periodCounter_;
+};
+
+#endif
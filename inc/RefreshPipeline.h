@@ -0,0 +1,75 @@
+#ifndef _REFRESHPIPELINE_H_
+#define _REFRESHPIPELINE_H_
+
+/*
+ * A weather refresh as a fixed sequence of stages: an optional location
+ * fix, then the fetch. The owner starts each stage's asynchronous work from
+ * the stage's start callback and reports back with Complete or Fail. Every
+ * stage has a deadline, and a refresh can be cancelled at any point; either
+ * way the stage's stop callback runs and the pipeline is idle again, so
+ * there is no state a refresh can get stuck in. Reports for a stage that
+ * is no longer current are ignored.
+ */
+class RefreshPipeline
+{
+public:
+	enum Stage {
+		STAGE_IDLE,
+		STAGE_LOCATION,
+		STAGE_FETCH,
+		STAGES_NUM
+	};
+
+	enum Outcome {
+		OUTCOME_DONE,
+		OUTCOME_FAILED,
+		OUTCOME_TIMEOUT,
+		OUTCOME_CANCELLED,
+		OUTCOMES_NUM
+	};
+
+	// Returns false if the work couldn't be started
+	typedef bool (*StartCallback)(void* data);
+	// Once per successful start. completed - the stage reported success.
+	typedef void (*StopCallback)(bool completed, void* data);
+	// Arm a timer that calls Expire in seconds, 0 - disarm
+	typedef void (*DeadlineCallback)(int seconds, void* data);
+	// stage - the stage the refresh ended in
+	typedef void (*FinishedCallback)(Stage stage, Outcome outcome, void* data);
+
+	struct Definition
+	{
+		int deadline; // seconds
+		StartCallback start;
+		StopCallback stop;
+	};
+
+	RefreshPipeline();
+
+	void Init(const Definition* location, const Definition* fetch,
+			DeadlineCallback deadline, FinishedCallback finished, void* data);
+
+	// Returns false if a refresh is already running
+	bool Start(bool locate);
+	void Complete(Stage stage);
+	void Fail(Stage stage);
+	void Expire();
+	void Cancel();
+
+	Stage Current() const { return current_; }
+	bool Running() const { return current_ != STAGE_IDLE; }
+	static const char* StageName(Stage stage);
+	static const char* OutcomeName(Outcome outcome);
+private:
+	void enter(Stage stage);
+	void leave(bool completed);
+	void finish(Stage stage, Outcome outcome);
+
+	const Definition* stages_[STAGES_NUM];
+	DeadlineCallback deadline_;
+	FinishedCallback finished_;
+	void* data_;
+	Stage current_;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef _SENSORHUB_H_
+#define _SENSORHUB_H_
+#include <time.h>
+#include "Platform.h"
+#include "SensorPolicy.h"
+#include "SpscQueue.h"
+
+/*
+ * Owns the sensor listeners. Sensor callbacks only push samples into their
+ * channel's lock-free queue; the UI drains them once per tick and folds the
+ * samples into one value per sensor according to its aggregation. Each
+ * sensor's callbacks come one at a time, but different sensors may call
+ * back on different threads at once, so every channel has its own queue
+ * and is the only producer for it.
+ */
+class SensorHub
+{
+public:
+	enum Aggregation {
+		AGGREGATE_LAST,
+		AGGREGATE_MEAN,
+		AGGREGATE_MAX
+	};
+
+	SensorHub();
+	~SensorHub();
+
+	bool Subscribe(Sensors::Kind kind, Aggregation aggregation);
+	bool Available(Sensors::Kind kind) const { return findChannel(kind) != nullptr; }
+	void SetPolicy(Sensors::Kind kind, const SensorPolicy::Policy& policy);
+
+	// Reads the sensor directly, without waiting for a callback
+	bool Read(Sensors::Kind kind);
+	// True when the value isn't kept fresh by callbacks
+	bool NeedsRead(Sensors::Kind kind) const;
+	bool HasData(Sensors::Kind kind) const;
+	float Value(Sensors::Kind kind) const;
+
+	// UI thread, once per tick. Returns the number of samples drained.
+	int Drain();
+	// Rolls the hourly wakeup statistics
+	void Tick(time_t now);
+private:
+	static constexpr int maxChannels = 4;
+
+	struct Channel
+	{
+		SensorHub* hub;
+		Sensors::Kind kind;
+		SensorDevice* device;
+		Aggregation aggregation;
+		SensorPolicy::Policy policy;
+		bool started;
+		bool hasData;
+		float value;
+		// Samples drained in the current tick
+		int count;
+		double sum;
+		float max;
+		// Hourly statistics, wakeups are counted on the sensor thread
+		std::atomic<int> wakeups;
+		int reads;
+		// Sensor thread to UI thread
+		SpscQueue<float, 64> queue;
+	};
+
+	static void eventCallback(float value, void* data);
+	void onEvent(Channel* channel, float value);
+	Channel* findChannel(Sensors::Kind kind);
+	const Channel* findChannel(Sensors::Kind kind) const;
+
+	Channel channels_[maxChannels];
+	int channelsNum_;
+	std::atomic<int> dropped_;
+	time_t hourStart_;
+};
+
+#endif
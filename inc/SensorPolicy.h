@@ -0,0 +1,38 @@
+#ifndef _SENSORPOLICY_H_
+#define _SENSORPOLICY_H_
+
+/*
+ * How sensor samples are delivered for a given face state. The pedometer
+ * is a cumulative counter, so it can be paused or batched without losing
+ * steps; only the freshness of the displayed number changes.
+ */
+class SensorPolicy
+{
+public:
+	enum FaceState {
+		FACE_INTERACTIVE,
+		FACE_AMBIENT,
+		FACE_HIDDEN
+	};
+
+	enum Delivery {
+		DELIVERY_STREAM,    // callback every interval
+		DELIVERY_BATCHED,   // callbacks held back by the sensor hub up to batchLatency
+		DELIVERY_ON_DEMAND, // no callbacks, read once on the minute tick
+		DELIVERY_PAUSED     // listener stopped
+	};
+
+	struct Policy
+	{
+		Delivery delivery;
+		int interval;     // ms
+		int batchLatency; // ms
+	};
+
+	static FaceState StateOf(bool paused, bool ambient);
+	// tierInterval is the power tier pedometer interval, 0 - on demand only.
+	// quiet - the wearer is asleep, see QuietMode.
+	static Policy ForPedometer(FaceState state, int tierInterval, bool quiet);
+};
+
+#endif
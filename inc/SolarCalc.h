@@ -0,0 +1,23 @@
+#ifndef _SOLARCALC_H_
+#define _SOLARCALC_H_
+#include <time.h>
+
+/*
+ * On-device sun and moon calculations (NOAA solar equations), so the sun
+ * markers only need a position and no network.
+ */
+class SolarCalc
+{
+public:
+	// Sunrise and sunset of the local calendar day containing `day`.
+	// Returns false during polar day or night.
+	static bool SunEvents(double latitude, double longitude, time_t day, time_t* sunrise, time_t* sunset);
+
+	// Moon age as a fraction of the synodic month: 0 - new, 0.5 - full
+	static double MoonAge(time_t time);
+	// Illuminated fraction of the moon disc, 0..1
+	static double MoonIllumination(time_t time);
+	static const char* MoonPhaseName(time_t time);
+};
+
+#endif
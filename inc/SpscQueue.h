@@ -0,0 +1,50 @@
+#ifndef _SPSCQUEUE_H_
+#define _SPSCQUEUE_H_
+#include <atomic>
+#include <stddef.h>
+
+/*
+ * Bounded lock-free queue for exactly one producer and one consumer
+ * thread. Size has to be a power of two.
+ */
+template <typename T, size_t Size>
+class SpscQueue
+{
+	static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "Size has to be a power of two");
+public:
+	SpscQueue(): head_(0), tail_(0) {}
+
+	// Producer side. Returns false if the queue is full.
+	bool Push(const T& item)
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) == Size) {
+			return false;
+		}
+		items_[tail & (Size - 1)] = item;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side. Returns false if the queue is empty.
+	bool Pop(T& item)
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = items_[head & (Size - 1)];
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+private:
+	// Padding keeps the producer and consumer indices on separate cache
+	// lines. Not alignas, objects holding the queue are heap allocated.
+	std::atomic<size_t> head_;
+	char headPadding_[64 - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> tail_;
+	char tailPadding_[64 - sizeof(std::atomic<size_t>)];
+	T items_[Size];
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+#include <atomic>
+#include <stdint.h>
+
+/*
+ * Process wide counters of everything that wakes the face up or makes it
+ * do work. Counting is a relaxed atomic add from any thread; readers take
+ * a snapshot and compare it with an earlier one.
+ */
+class Stats
+{
+public:
+	enum Counter {
+		// Main thread
+		ANIMATOR_FRAMES_RENDERED,
+		ANIMATOR_FRAMES_SKIPPED,
+		TIME_TICKS,
+		AMBIENT_TICKS,
+		TIMER_CALLBACKS,
+		LOCATION_CHANGES,
+		IMAGE_LOADS,
+		TEXT_SETS,
+		SOURCE_REFRESHES,
+		// Sensor and worker threads
+		SENSOR_CALLBACKS,
+		HTTP_REQUESTS,
+		COUNTERS_NUM
+	};
+
+	static constexpr int maxTimers = 8;
+
+	struct TimerStat
+	{
+		const char* name;
+		int interval;
+		uint32_t callbacks;
+	};
+
+	struct Snapshot
+	{
+		uint32_t values[COUNTERS_NUM];
+		// Per timer name, so a re-created timer carries on counting
+		TimerStat timers[maxTimers];
+		int timersNum;
+	};
+
+	static void Add(Counter counter)
+	{
+		slot(counter).fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Main thread, from Timer, along with TIMER_CALLBACKS
+	static void AddTimerCallback(const char* name, int interval);
+
+	// Main thread
+	static void Take(Snapshot& snapshot);
+	static const char* Name(Counter counter);
+	// Logs what happened between two snapshots
+	static void LogDelta(const Snapshot& from, const Snapshot& to);
+private:
+	static constexpr int mainCountersNum = SENSOR_CALLBACKS;
+
+	// Counters written by other threads live on their own cache line, so
+	// sensor callbacks don't bounce the line the main thread writes to
+	struct alignas(64) Line
+	{
+		std::atomic<uint32_t> values[mainCountersNum];
+	};
+
+	static std::atomic<uint32_t>& slot(Counter counter)
+	{
+		return counter < mainCountersNum ? mainLine_.values[counter] : threadLine_.values[counter - mainCountersNum];
+	}
+
+	static Line mainLine_;
+	static Line threadLine_;
+	static TimerStat timers_[maxTimers];
+	static int timersNum_;
+};
+
+#endif
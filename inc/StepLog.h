@@ -0,0 +1,77 @@
+#ifndef _STEPLOG_H_
+#define _STEPLOG_H_
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Per-minute step history for the last few days in a fixed size memory
+ * mapped ring file. Every record carries the raw pedometer counter, a
+ * sequence number and a check word, so a record torn by a crash is
+ * detected and dropped and the ring position can be recovered from the
+ * records themselves. A clock set back starts a new baseline: a record
+ * with no steps at the corrected minute, the steps in between are lost.
+ */
+class StepLog
+{
+public:
+	static constexpr int daysNum = 7;
+	static constexpr uint32_t capacity = daysNum * 24 * 60;
+
+	StepLog();
+	~StepLog();
+
+	// Without a path the log lives in anonymous memory for this run only
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen() const { return header_ != nullptr; }
+	// Drops the mapped records from memory, they're read back from the file
+	// when touched. Returns false for a log without a file.
+	bool Trim();
+
+	// Local midnight of the current day. Recounts the day totals.
+	void SetDay(time_t dayStart);
+	// O(1). Once per minute at most, later calls in the same minute are
+	// ignored. An earlier minute than the last record's starts a baseline.
+	void Append(time_t now, int counter);
+
+	// Steps counted by the sensor since the last append
+	int Pending(int counter) const;
+	int TodaySteps() const { return todaySteps_; }
+	int HourSteps(int hour) const { return hourSteps_[hour]; }
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t capacity;
+		uint32_t head;
+		uint32_t count;
+		uint32_t check;
+	};
+
+	struct Record
+	{
+		uint32_t minute; // since the epoch, goes back with the clock
+		uint32_t sequence; // one more than the record before
+		int32_t counter;
+		uint16_t steps;
+		uint16_t check;
+	};
+
+	static uint32_t headerCheck(const Header* header);
+	static uint16_t recordCheck(const Record* record);
+	static bool recordValid(const Record* record);
+	void reset();
+	void recover();
+	void addToDay(const Record* record);
+	const Record* last() const;
+
+	int fd_;
+	Header* header_;
+	Record* records_;
+	time_t dayStart_;
+	int todaySteps_;
+	int hourSteps_[24];
+};
+
+#endif
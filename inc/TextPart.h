@@ -0,0 +1,23 @@
+#ifndef _TEXTPART_H_
+#define _TEXTPART_H_
+
+#include <Elementary.h>
+
+/*
+ * Layout text part that remembers its last content. Setting the same text
+ * again is a no-op, so the textblock is only re-laid out when it changes.
+ */
+class TextPart
+{
+public:
+	explicit TextPart(const char* name);
+
+	void Set(Evas_Object* layout, const char* text);
+	void Invalidate() { valid_ = false; }
+private:
+	const char* name_;
+	char text_[128];
+	bool valid_;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef _THEME_H_
+#define _THEME_H_
+
+/*
+ * The look of the dial: layout, background and hand images and the hand
+ * geometry, read from a theme pack manifest so a new look doesn't need a
+ * new build. A manifest only lists what differs from the built-in look.
+ *
+ *   # comment
+ *   name <name>
+ *   layout <edj file> <group>
+ *   image <asset name> <file>
+ *   hand <hour|min|sec> <width> <height> <shadow padding>
+ *   sun <icon size>
+ *
+ * Geometry is in BASE_WIDTH x BASE_HEIGHT coordinates. Files starting with
+ * "./" are in the pack's directory, others are resources of the app, so a
+ * pack reuses the built-in images by naming them.
+ */
+class Theme
+{
+public:
+	enum Asset {
+		ASSET_BG,
+		ASSET_BG_AMBIENT,
+		ASSET_HAND_HOUR,
+		ASSET_HAND_HOUR_SHADOW,
+		ASSET_HAND_MIN,
+		ASSET_HAND_MIN_SHADOW,
+		ASSET_HAND_SEC,
+		ASSET_HAND_SEC_SHADOW,
+		ASSET_SUNRISE,
+		ASSET_SUNSET,
+		ASSETS_NUM
+	};
+
+	enum Hand {
+		HAND_HOUR,
+		HAND_MIN,
+		HAND_SEC,
+		HANDS_NUM
+	};
+
+	struct HandGeometry
+	{
+		int width;
+		int height;
+		int shadowPadding; // shadow offset down from the hand
+	};
+
+	static constexpr int maxName = 32;
+	static constexpr int maxFile = 96;
+
+	// The built-in look
+	Theme();
+
+	// Returns false on a line that can't be parsed, keys it doesn't know are skipped
+	bool Parse(const char* text);
+	bool Load(const char* path);
+
+	const char* Name() const { return name_; }
+	const char* Layout() const { return layout_; }
+	const char* Group() const { return group_; }
+	const char* File(Asset asset) const { return files_[asset]; }
+	const HandGeometry& GetHand(Hand hand) const { return hands_[hand]; }
+	int SunIconSize() const { return sunIconSize_; }
+
+	// File is relative to the pack's directory
+	static bool InPack(const char* file);
+	static const char* AssetName(Asset asset);
+	static const char* HandName(Hand hand);
+private:
+	bool parseLine(char* line);
+
+	char name_[maxName];
+	char layout_[maxFile];
+	char group_[maxName];
+	char files_[ASSETS_NUM][maxFile];
+	HandGeometry hands_[HANDS_NUM];
+	int sunIconSize_;
+};
+
+#endif
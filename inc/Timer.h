@@ -1,20 +1,34 @@
 #ifndef _TIMER_H_
 #define _TIMER_H_
-#include "omahawatch.h"
-#include <Elementary.h>
-#include <dlog.h>
-#include <list>
-using namespace std;
+#include <stdint.h>
+#include "Stats.h"
 
 class Timer {
 	struct Event;
 public:
 	typedef bool(*TimerCallback)(void *data);
-	typedef Timer::Event* TimerHandle;
+
+	// Slot and id of a timer. A handle kept after its timer went away no
+	// longer matches the slot, so it can't delete the slot's next timer.
+	struct TimerHandle
+	{
+		TimerHandle(): slot(-1), id(0) {}
+		TimerHandle(int slot, uint32_t id): slot(slot), id(id) {}
+		explicit operator bool() const { return id != 0; }
+
+		int slot;
+		uint32_t id;
+	};
+
+	// Events live in a fixed table, adding and firing timers never allocates
+	static constexpr int capacity = 8;
 
 	static Timer& GetInstance();
 
-	TimerHandle AddTimer(int seconds, TimerCallback cb, void* data);
+	// name is only used for statistics and has to outlive the timer.
+	// Returns an empty handle if all slots are taken.
+	TimerHandle AddTimer(int seconds, TimerCallback cb, void* data, const char* name = "unnamed");
+	// Does nothing if the timer has already gone
 	void DeleteTimer(TimerHandle handle);
 	void Tick();
 private:
@@ -23,16 +37,19 @@ private:
 
 	struct Event
 	{
+		uint32_t id; // 0 - free slot
 		int time;
 		int interval;
 		TimerCallback cb;
 		void* data;
+		const char* name;
 	};
 
 	void advanceTime();
-	void addEvent(Event* event);
+	Event* nextDue();
 
-	list<Event*> events_;
+	Event events_[capacity];
+	uint32_t lastId_;
 	int lastTimestamp_;
 };
 
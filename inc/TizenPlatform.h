@@ -0,0 +1,15 @@
+#ifndef _TIZENPLATFORM_H_
+#define _TIZENPLATFORM_H_
+
+/*
+ * Platform services backed by Ecore, dlog, the sensor, location, device
+ * and connection APIs.
+ */
+class TizenPlatform
+{
+public:
+	static void Install();
+	static void Uninstall();
+};
+
+#endif
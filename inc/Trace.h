@@ -0,0 +1,88 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+/*
+ * Compact binary trace of what the face gets from the outside: ticks,
+ * visibility changes, sensor values, location sessions, HTTP results,
+ * battery, network and clock changes. Recorded on the watch and replayed
+ * by the host simulator. Records are 16 bytes in native byte order, and a
+ * run of ticks one second apart shares a single record. Record times
+ * follow Clock::Monotonic(), which counts suspended time too, so setting
+ * the watch's time doesn't move them; the wall clock is the start plus the time plus the offset of the
+ * last KIND_TIME_CHANGED.
+ */
+class Trace
+{
+public:
+	enum Kind {
+		KIND_TICK,           // count - ticks one second apart
+		KIND_VISIBILITY,     // paused, ambient
+		KIND_SENSOR,         // Sensors::Kind, value
+		KIND_LOCATION_START, // LocationScheduler::Method
+		KIND_LOCATION_STOP,
+		KIND_LOCATION_FIX,   // latitude, longitude in microdegrees
+		KIND_HTTP,           // curl error or httpBadResponse, latency in ms; count - response bytes
+		KIND_BATTERY,        // percent, charging
+		KIND_CONNECTIVITY,   // online
+		KIND_TIME_CHANGED,   // wall clock offset in seconds
+		KINDS_NUM
+	};
+
+	struct Record
+	{
+		uint32_t time; // monotonic ms since the start of the trace
+		uint16_t kind;
+		uint16_t count;
+		int32_t args[2];
+	};
+
+	// A response came in but couldn't be parsed
+	static constexpr int httpBadResponse = -1;
+
+	Trace();
+	~Trace();
+
+	// Recording starts at the platform clock's current time
+	bool Open(const char* path);
+	void Close();
+	bool Recording() const { return file_ != nullptr; }
+
+	void Add(Kind kind, int arg0 = 0, int arg1 = 0, int count = 1);
+	void Tick();
+	// The wall clock was set, records its new offset
+	void TimeChanged();
+	// Records are buffered, a paused face may not get the chance later
+	void Flush();
+
+	// Reads a whole trace. start is the unix time of its first millisecond.
+	static bool Load(const char* path, double* start, std::vector<Record>& records);
+	static const char* KindName(Kind kind);
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		int64_t start; // unix time, ms
+	};
+
+	static constexpr int bufferSize = 256;
+	// About a month of a typical wearer, then recording stops
+	static constexpr long maxRecords = 256 * 1024;
+
+	Record* append(Kind kind);
+	uint32_t elapsed() const;
+
+	FILE* file_;
+	int64_t start_;
+	// Clock::Monotonic() at the start
+	double monotonicStart_;
+	Record buffer_[bufferSize];
+	int buffered_;
+	long written_;
+};
+
+#endif
@@ -1,27 +1,28 @@
 #ifndef _WEATHERINFO_H_
 #define _WEATHERINFO_H_
-#include <json-glib/json-glib.h>
 
 class WeatherInfo
 {
 public:
 	WeatherInfo();
 
+	// OpenWeatherMap current weather. In WeatherJson.cpp on the watch,
+	// the host build has its own without json-glib.
 	bool FromJson(const char* json);
 	const char* Icon() {return icon_;}
-	time_t Sunset() {return sunset_;}
-	time_t Sunrise() {return sunrise_;}
-	void GetString(char* str, int len);
+	const char* Location() {return location_;}
+	void GetDetails(char* str, int len);
 	bool Ready() {return ready_;}
 	void ToggleScale() { celsius_ = !celsius_; }
+	// Takes freshly fetched data but keeps the scale picked by the user
+	void Assign(const WeatherInfo& other) { bool celsius = celsius_; *this = other; celsius_ = celsius; }
 private:
-	JsonNode* getNode(JsonObject* parent, const char* name);
-	JsonNode* getNodePath(JsonObject* parent, const char* path);
+	// Takes the parsed fields and stamps the update time
+	void set(const char* location, const char* icon, double kelvin);
+
 	float temp_ = 0;
 	char location_[128];
 	char icon_[64];
-	time_t sunset_ = 0;
-	time_t sunrise_ = 0;
 	bool ready_ = false;
 	bool celsius_ = true;
 	int updateHour_ = 0;
@@ -0,0 +1,84 @@
+#ifndef _WORKERPOOL_H_
+#define _WORKERPOOL_H_
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Shared cancellation flag. Copies refer to the same flag.
+ */
+class CancelToken
+{
+public:
+	CancelToken(): cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+	void Cancel() { cancelled_->store(true); }
+	bool Cancelled() const { return cancelled_->load(); }
+private:
+	std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+/*
+ * Runs blocking work (network, parsing, disk) off the UI thread and hands
+ * the result back on the main loop. Work functions must not touch Evas or
+ * the Face; only the done callback runs on the main thread, and not at all
+ * if the token was cancelled by then.
+ */
+class WorkerPool
+{
+public:
+	static WorkerPool& GetInstance();
+	static bool OnMainThread();
+
+	template <typename T>
+	void Submit(const CancelToken& token, std::function<T(const CancelToken&)> work, std::function<void(T&)> done)
+	{
+		post([token, work, done]() {
+			if (token.Cancelled()) {
+				return;
+			}
+			auto result = std::make_shared<T>(work(token));
+			if (token.Cancelled()) {
+				return;
+			}
+			runOnMainLoop([token, done, result]() {
+				if (!token.Cancelled()) {
+					done(*result);
+				}
+			});
+		});
+	}
+
+	void Shutdown();
+	// Stops the threads if no work is queued or running; they are started
+	// again by the next Submit. Returns false if the pool was busy.
+	bool Trim();
+	// Nothing queued or running, every result is posted to the main loop
+	bool Idle();
+private:
+	static constexpr int threadsNum = 2;
+
+	WorkerPool();
+	~WorkerPool();
+
+	void post(std::function<void()>&& job);
+	void workerLoop();
+	static void runOnMainLoop(std::function<void()>&& job);
+	static void mainLoopCallback(void* data);
+
+	std::vector<std::thread> threads_;
+	std::deque<std::function<void()>> jobs_;
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	bool stopping_;
+	bool trimming_;
+	int busy_;
+	std::thread::id mainThread_;
+};
+
+#endif
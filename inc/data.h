@@ -3,5 +3,6 @@
 
 
 void data_get_resource_path(const char *file_in, char *file_path_out, int file_path_max);
+void data_get_data_path(const char *file_in, char *file_path_out, int file_path_max);
 
 #endif
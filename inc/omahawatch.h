@@ -10,17 +10,37 @@
 #endif
 #define LOG_TAG "omahawatch"
 
-#define IMAGE_BG "images/chrono_clock_bg.png"
-#define IMAGE_BG_BLACK "images/chrono_clock_bg_black.png"
-
-#define IMAGE_HANDS_SEC "images/chrono_hand_sec.png"
-#define IMAGE_HANDS_MIN "images/chrono_hand_min.png"
-#define IMAGE_HANDS_HOUR "images/chrono_hand_hour.png"
-#define IMAGE_HANDS_SEC_SHADOW "images/chrono_hand_sec_shadow.png"
-#define IMAGE_HANDS_MIN_SHADOW "images/chrono_hand_min_shadow.png"
-#define IMAGE_HANDS_HOUR_SHADOW "images/chrono_hand_hour_shadow.png"
-
-#define EDJ_FILE "edje/main.edj"
+/* Theme packs, see Theme. Packs in the data directory come before the
+ * ones shipped in the resources. */
+#define THEMES_DIR "themes"
+#define THEME_MANIFEST "theme.txt"
+#define THEME_DEFAULT "chrono"
+/* Name of the selected theme, in the data directory */
+#define THEME_SELECTED_FILE "theme"
+/* app_control extra data that switches the theme */
+#define THEME_CONTROL_EXTRA "theme"
+
+/* Quiet hours, see QuietMode::ParseSchedule. Saved in the data directory,
+ * set with the app_control extra. */
+#define QUIET_SCHEDULE_FILE "quiet"
+#define QUIET_CONTROL_EXTRA "quiet"
+
+#define STEP_LOG_FILE "steps.log"
+
+/* OpenWeatherMap current weather, the query is added per request */
+#define WEATHER_URL "http://api.openweathermap.org/data/2.5/weather"
+
+/* Input trace for the host simulator, see Trace. Debug builds record by
+ * default, others with -DTRACE_INPUTS=1. */
+#ifndef TRACE_INPUTS
+#ifdef _DEBUG
+#define TRACE_INPUTS 1
+#else
+#define TRACE_INPUTS 0
+#endif
+#endif
+#define TRACE_FILE "trace.bin"
+#define TRACE_PREV_FILE "trace.prev.bin"
 
 
 #define PARTS_TYPE_NUM 6
@@ -34,17 +54,7 @@
 #define BASE_WIDTH 360
 #define BASE_HEIGHT 360
 
-#define HANDS_SEC_WIDTH 28
-#define HANDS_SEC_HEIGHT 360
-#define HANDS_MIN_WIDTH 28
-#define HANDS_MIN_HEIGHT 360
-#define HANDS_HOUR_WIDTH 28
-#define HANDS_HOUR_HEIGHT 360
-
-#define HANDS_SEC_SHADOW_PADDING 3
-#define HANDS_MIN_SHADOW_PADDING 6
-#define HANDS_HOUR_SHADOW_PADDING 6
-
+/* Sun icon size the day plan markers are laid out for */
 #define SUN_ICON_WIDTH 20
 #define SUN_ICON_HEIGHT 20
 
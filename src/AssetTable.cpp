@@ -0,0 +1,59 @@
+#include "AssetTable.h"
+#include <string.h>
+#include "Log.h"
+
+AssetTable::AssetTable():
+	entries_()
+{
+}
+
+int AssetTable::Acquire(const char* file)
+{
+	size_t len = strlen(file);
+	if (len >= maxFile) {
+		LOG_E("Asset path too long: %s", file);
+		return -1;
+	}
+	int free = -1;
+	for (int i = 0; i < maxAssets; ++i) {
+		Entry& entry = entries_[i];
+		if (entry.users > 0 && !strcmp(entry.file, file)) {
+			++entry.users;
+			return i;
+		}
+		if (entry.users == 0 && free < 0) {
+			free = i;
+		}
+	}
+	if (free < 0) {
+		LOG_E("Asset table full, %s not loaded", file);
+		return -1;
+	}
+	memcpy(entries_[free].file, file, len + 1);
+	entries_[free].users = 1;
+	return free;
+}
+
+void AssetTable::Retain(int asset)
+{
+	if (asset >= 0) {
+		++entries_[asset].users;
+	}
+}
+
+void AssetTable::Release(int asset)
+{
+	if (asset < 0 || entries_[asset].users == 0) {
+		return;
+	}
+	--entries_[asset].users;
+}
+
+int AssetTable::Size() const
+{
+	int size = 0;
+	for (const Entry& entry: entries_) {
+		size += entry.users > 0;
+	}
+	return size;
+}
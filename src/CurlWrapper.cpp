@@ -2,9 +2,8 @@
 
 #include <functional>
 #include <curl/curl.h>
-#include <net_connection.h>
-#include <dlog.h>
-#include "omahawatch.h"
+#include "Log.h"
+#include "Stats.h"
 
 class StringContext
 {
@@ -26,6 +25,12 @@ private:
     std::string& data_;
 };
 
+static int ProgressCallback(void* userp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+	auto cancel = static_cast<const CancelToken*>(userp);
+	return cancel->Cancelled() ? 1 : 0;
+}
+
 class finally
 {
 public:
@@ -35,62 +40,55 @@ private:
 	std::function<void(void)> f_;
 };
 
-std::string CurlWrapper::Get(const std::string& url, int& err, bool useProxy/* = true*/)
+std::string CurlWrapper::Get(const std::string& url, int& err, const CancelToken* cancel/* = nullptr*/, const std::string& proxy/* = std::string()*/)
 {
 	CURL *curl;
 	CURLcode curlErr;
 	curl = curl_easy_init();
-	char *proxyAddress = nullptr;
-	connection_h connection;
-	int connErr;
-	connErr = connection_create(&connection);
-	finally f([&curl, &connection, &proxyAddress]() {
+	finally f([&curl]() {
 		curl_easy_cleanup(curl);
-		connection_destroy(connection);
-		free(proxyAddress);
-		dlog_print(DLOG_DEBUG, LOG_TAG, "Curl cleanup");
+		LOG_D("Curl cleanup");
 	});
-	if (connErr != CONNECTION_ERROR_NONE) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "ERROR1 %s", get_error_message(connErr));
-		err = 0b1000000000000000 | connErr;
-		return NULL;
-	}
 	std::string res;
 	StringContext ctx(res);
-	dlog_print(DLOG_DEBUG, LOG_TAG, "%s", url.c_str());
+	LOG_D("%s", url.c_str());
 	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+#if LOG_LEVEL >= LOG_LEVEL_VERBOSE
 	curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
+#endif
 	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ctx);
 	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &StringContext::WriteCallback);
 	curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5);
+	// Runs off the main thread, so no SIGALRM based DNS timeouts
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
+	if (cancel) {
+		curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
+		curl_easy_setopt(curl, CURLOPT_XFERINFODATA, cancel);
+		curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+	}
 
+	bool useProxy = !proxy.empty();
 	if (useProxy) {
-		connErr = connection_get_proxy(connection, CONNECTION_ADDRESS_FAMILY_IPV4, &proxyAddress);
-		if (connErr != CONNECTION_ERROR_NONE) {
-			dlog_print(DLOG_ERROR, LOG_TAG, "ERROR1.3 %s", get_error_message(connErr));
-			err = 0b0100000000000000 | connErr;
-			return "";
-		}
-		if (proxyAddress && *proxyAddress) {
-			dlog_print(DLOG_DEBUG, LOG_TAG, "Using proxy: %s", proxyAddress);
-			curl_easy_setopt(curl, CURLOPT_PROXY, proxyAddress);
-		} else {
-			dlog_print(DLOG_DEBUG, LOG_TAG, "Got empty proxy. Ignoring");
-		}
+		LOG_D("Using proxy: %s", proxy.c_str());
+		curl_easy_setopt(curl, CURLOPT_PROXY, proxy.c_str());
 	}
 
+	Stats::Add(Stats::HTTP_REQUESTS);
 	curlErr = curl_easy_perform(curl);
 	if (curlErr == CURLE_OPERATION_TIMEDOUT && useProxy) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Curl timed out with proxy. Trying without...");
-		std::string res = Get(url, err, false);
-		err |= 0b0010000000000000;
+		LOG_E("Curl timed out with proxy. Trying without...");
+		std::string res = Get(url, err, cancel);
+		err |= errorProxyTimedOut;
 		return res;
+	} else if (curlErr == CURLE_ABORTED_BY_CALLBACK) {
+		LOG_D("Curl request cancelled");
+		err |= curlErr;
+		res = "";
 	} else if (curlErr != CURLE_OK) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "ERROR2 %d %d", curlErr, useProxy);
+		LOG_E("ERROR2 %d %d", curlErr, useProxy);
 		err |= curlErr;
 		res = "";
 	}
 
 	return res;
 }
-
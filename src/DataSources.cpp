@@ -0,0 +1,101 @@
+#include "DataSources.h"
+#include <string.h>
+#include "Log.h"
+#include "Stats.h"
+
+DataSources::DataSources():
+	sources_(),
+	sourcesNum_(0)
+{
+}
+
+int DataSources::Register(const Definition* definition, RefreshCallback cb, void* data)
+{
+	if (sourcesNum_ == maxSources) {
+		LOG_E("No free slot for data source %s", definition->name);
+		return -1;
+	}
+	Source& source = sources_[sourcesNum_];
+	source.definition = definition;
+	source.cb = cb;
+	source.data = data;
+	source.refreshed = 0;
+	source.pushed = false;
+	source.refreshes = 0;
+	return sourcesNum_++;
+}
+
+void DataSources::Push(int source)
+{
+	if (source >= 0 && source < sourcesNum_) {
+		sources_[source].pushed = true;
+	}
+}
+
+void DataSources::InvalidatePart(const char* part)
+{
+	Push(findOwner(part));
+}
+
+void DataSources::InvalidateAll()
+{
+	for (int i = 0; i < sourcesNum_; ++i) {
+		sources_[i].pushed = true;
+	}
+}
+
+int DataSources::Tick(time_t now)
+{
+	int refreshed = 0;
+	for (int i = 0; i < sourcesNum_; ++i) {
+		if (due(sources_[i], now)) {
+			Refresh(i, now);
+			++refreshed;
+		}
+	}
+	return refreshed;
+}
+
+void DataSources::Refresh(int source, time_t now)
+{
+	if (source < 0 || source >= sourcesNum_) {
+		return;
+	}
+	Source& entry = sources_[source];
+	// Set before the callback, it may push its own source again
+	entry.refreshed = now;
+	entry.pushed = false;
+	++entry.refreshes;
+	Stats::Add(Stats::SOURCE_REFRESHES);
+	entry.cb(now, entry.data);
+}
+
+const char* DataSources::Owner(const char* part) const
+{
+	int source = findOwner(part);
+	return source < 0 ? nullptr : sources_[source].definition->name;
+}
+
+bool DataSources::due(const Source& source, time_t now) const
+{
+	if (source.pushed || source.refreshed == 0) {
+		return true;
+	}
+	const Definition* definition = source.definition;
+	if (definition->cadence > 0 && now / definition->cadence != source.refreshed / definition->cadence) {
+		return true;
+	}
+	return definition->staleness > 0 && now - source.refreshed >= definition->staleness;
+}
+
+int DataSources::findOwner(const char* part) const
+{
+	for (int i = 0; i < sourcesNum_; ++i) {
+		for (auto owned: sources_[i].definition->parts) {
+			if (owned && !strcmp(owned, part)) {
+				return i;
+			}
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,80 @@
+#include "DayPlan.h"
+#include "omahawatch.h"
+#include <math.h>
+
+static constexpr time_t secondsInDay = 24 * 60 * 60;
+
+// Events are compared at minute resolution: an event is "now" for the
+// whole minute it happens in.
+static inline time_t minuteOf(time_t time)
+{
+	return time / 60;
+}
+
+DayPlan::DayPlan():
+	next_(0),
+	sunriseMarker_({0, 0}),
+	sunsetMarker_({0, 0}),
+	ready_(false)
+{
+}
+
+void DayPlan::Build(time_t sunrise, time_t sunset, time_t now)
+{
+	ready_ = sunrise > 0 && sunset > sunrise;
+	if (!ready_) {
+		return;
+	}
+	events_[0] = { sunrise, EVENT_SUNRISE };
+	events_[1] = { sunset, EVENT_SUNSET };
+	rollOver(now);
+	Advance(now);
+}
+
+bool DayPlan::Advance(time_t now)
+{
+	if (!ready_) {
+		return false;
+	}
+	while (next_ < eventsNum && minuteOf(events_[next_].time) < minuteOf(now)) {
+		++next_;
+	}
+	if (next_ < eventsNum) {
+		return false;
+	}
+	rollOver(now);
+	return true;
+}
+
+int DayPlan::MinutesUntilNext(time_t now) const
+{
+	return (int)(minuteOf(events_[next_].time) - minuteOf(now));
+}
+
+void DayPlan::rollOver(time_t now)
+{
+	// The sun events of the following day are within a couple of minutes of
+	// the same instants 24 hours later
+	while (minuteOf(events_[eventsNum - 1].time) < minuteOf(now)) {
+		for (int i = 0; i < eventsNum; ++i) {
+			events_[i].time += secondsInDay;
+		}
+	}
+	next_ = 0;
+	sunriseMarker_ = markerFor(events_[0].time);
+	sunsetMarker_ = markerFor(events_[1].time);
+}
+
+DayPlan::Marker DayPlan::markerFor(time_t time)
+{
+	struct tm timeInfo;
+	localtime_r(&time, &timeInfo);
+	double degree = (timeInfo.tm_hour % 12) * HOUR_ANGLE;
+	degree += timeInfo.tm_min * HOUR_ANGLE / 60.0 - 90;
+	double rsin = sin(degree * M_PI / 180.0);
+	double rcos = cos(degree * M_PI / 180.0);
+	Marker marker;
+	marker.x = (BASE_WIDTH / 2 - SUN_ICON_WIDTH / 2) * (1 + rcos);
+	marker.y = (BASE_HEIGHT / 2 - SUN_ICON_HEIGHT / 2) * (1 + rsin);
+	return marker;
+}
@@ -0,0 +1,47 @@
+#include "Diagnostics.h"
+#include <stdio.h>
+#include <unistd.h>
+#include "Log.h"
+
+int Diagnostics::ResidentKb()
+{
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (!statm) {
+		return -1;
+	}
+	long size = 0;
+	long resident = 0;
+	int read = fscanf(statm, "%ld %ld", &size, &resident);
+	fclose(statm);
+	if (read != 2) {
+		return -1;
+	}
+	return (int)(resident * (sysconf(_SC_PAGESIZE) / 1024));
+}
+
+int Diagnostics::countObject(Evas_Object* obj)
+{
+	int count = 1;
+	Eina_List* members = evas_object_smart_members_get(obj);
+	Eina_List* itr;
+	void* member;
+	EINA_LIST_FOREACH(members, itr, member) {
+		count += countObject(static_cast<Evas_Object*>(member));
+	}
+	eina_list_free(members);
+	return count;
+}
+
+int Diagnostics::ObjectCount(Evas* evas)
+{
+	int count = 0;
+	for (Evas_Object* obj = evas_object_bottom_get(evas); obj; obj = evas_object_above_get(obj)) {
+		count += countObject(obj);
+	}
+	return count;
+}
+
+void Diagnostics::LogScene(const char* stage, Evas* evas)
+{
+	LOG_I("%s: %d objects, %d kB resident", stage, ObjectCount(evas), ResidentKb());
+}
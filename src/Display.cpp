@@ -0,0 +1,59 @@
+#include "Display.h"
+#include <stdio.h>
+#include <string.h>
+#include "omahawatch.h"
+#include "Log.h"
+
+static constexpr char imagesPrefix[] = "images/";
+
+// The first entry is the base set, always installed
+static const Display::Resolution Resolutions[] = {
+		{ BASE_WIDTH, "images" },
+		{ 320, "images/320" },
+		{ 390, "images/390" }
+};
+
+Display::Display():
+	set_(&Resolutions[0]),
+	size_(BASE_WIDTH),
+	left_(0),
+	top_(0),
+	native_(true)
+{
+}
+
+void Display::Select(int width, int height, AvailableCallback available)
+{
+	// Round dials on square screens; anything else gets the dial centered
+	size_ = width < height ? width : height;
+	left_ = (width - size_) / 2;
+	top_ = (height - size_) / 2;
+	set_ = &Resolutions[0];
+	for (const Resolution& res : Resolutions) {
+		if (res.size == size_ && (&res == &Resolutions[0] || available(res.images))) {
+			set_ = &res;
+			break;
+		}
+	}
+	native_ = set_->size == size_;
+	if (native_) {
+		LOG_I("Display %dx%d, %s", width, height, set_->images);
+	} else {
+		LOG_W("Display %dx%d has no asset set, scaling %s", width, height, set_->images);
+	}
+}
+
+int Display::Scale(int base) const
+{
+	return (base * size_ + BASE_WIDTH / 2) / BASE_WIDTH;
+}
+
+const char* Display::ImagePath(const char* path, char* out, size_t len) const
+{
+	static constexpr size_t prefixLen = sizeof(imagesPrefix) - 1;
+	if (set_ == &Resolutions[0] || strncmp(path, imagesPrefix, prefixLen) != 0) {
+		return path;
+	}
+	snprintf(out, len, "%s/%s", set_->images, path + prefixLen);
+	return out;
+}
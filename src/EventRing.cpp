@@ -0,0 +1,98 @@
+#include "EventRing.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "Log.h"
+
+static const char* EventFormats[] = {
+		"updw",
+		"curl: %d",
+		"curl_e: %d",
+		"jsnerr",
+		"tmr %d",
+		"tier %d",
+		"CB %d",
+		"loc",
+		"meth %d",
+		"err2",
+		"err3",
+		"tmr fail",
+		"bat %d %d",
+		"net %d",
+		"time",
+		"amb %d %d ms",
+		"quiet %d",
+		"ref %d %d",
+		"prewake"
+};
+
+static_assert(sizeof(EventFormats) / sizeof(EventFormats[0]) == EventRing::EVENTS_NUM, "Event format missing");
+
+EventRing::EventRing():
+	written_(0)
+{
+}
+
+void EventRing::Add(Event event, int arg0/* = 0*/, int arg1/* = 0*/)
+{
+	Record& record = records_[written_ % capacity];
+	record.time = (uint32_t)Platform::Get().clock->Now();
+	record.event = event;
+	record.reserved = 0;
+	record.args[0] = arg0;
+	record.args[1] = arg1;
+	++written_;
+}
+
+int EventRing::Size() const
+{
+	return written_ < (uint32_t)capacity ? (int)written_ : capacity;
+}
+
+void EventRing::Get(int index, Event* event, int* arg0, int* arg1) const
+{
+	uint32_t first = written_ - Size();
+	const Record& record = records_[(first + index) % capacity];
+	*event = (Event)record.event;
+	*arg0 = record.args[0];
+	*arg1 = record.args[1];
+}
+
+int EventRing::Format(int index, char* str, int len) const
+{
+	uint32_t first = written_ - Size();
+	const Record& record = records_[(first + index) % capacity];
+	time_t time = record.time;
+	struct tm timeInfo;
+	localtime_r(&time, &timeInfo);
+	int written = snprintf(str, len, "%.2d:%.2d ", timeInfo.tm_hour, timeInfo.tm_min);
+	if (written >= len) {
+		return written;
+	}
+	return written + snprintf(str + written, len - written, EventFormats[record.event], record.args[0], record.args[1]);
+}
+
+void EventRing::FormatLast(int records, const char* separator, char* str, int len) const
+{
+	*str = '\0';
+	int size = Size();
+	int from = size > records ? size - records : 0;
+	int pos = 0;
+	for (int i = from; i < size && pos < len; ++i) {
+		pos += Format(i, str + pos, len - pos);
+		if (pos < len) {
+			pos += snprintf(str + pos, len - pos, "%s", separator);
+		}
+	}
+}
+
+void EventRing::Log() const
+{
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+	char line[64];
+	for (int i = 0; i < Size(); ++i) {
+		Format(i, line, sizeof(line));
+		LOG_D("Event: %s", line);
+	}
+#endif
+}
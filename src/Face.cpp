@@ -1,56 +1,15 @@
 #include "Face.h"
 #include "data.h"
-#include "CurlWrapper.h"
-#include <stdarg.h>
+#include "Diagnostics.h"
+#include "Log.h"
+#include <string.h>
+#include <unistd.h>
 #include <time.h>
-#include <string>
-#include <sstream>
-#include <iomanip>
-
-#ifdef _DEBUG
-#define WATCH_ERR(f, ...) \
-{ \
-	watch_time_h time; \
-	watch_time_get_current_time(&time); \
-	int hour, min; \
-	watch_time_get_hour(time, &hour); \
-	watch_time_get_minute(time, &min); \
-	setLastError("%.2d:%.2d " f, hour, min, __VA_ARGS__); \
-}
-#else
-#define WATCH_ERR(...)
-#endif
-
-static const char* Months[] = {
-		"Nul",
-		"Jan",
-		"Feb",
-		"Mar",
-		"Apr",
-		"May",
-		"Jun",
-		"Jul",
-		"Aug",
-		"Sep",
-		"Oct",
-		"Nov",
-		"Dec"
-};
-
-static const char* Weekdays[] = {
-		"Nul",
-		"Sun",
-		"Mon",
-		"Tue",
-		"Wed",
-		"Thu",
-		"Fri",
-		"Sat"
-};
 
 Face::Face(int width, int height):
 	window_(NULL),
 	bg_(NULL),
+	bgAmbient_(NULL),
 	layout_(NULL),
 	handSec_(NULL),
 	handMin_(NULL),
@@ -58,44 +17,54 @@ Face::Face(int width, int height):
 	handsSecShadow_(NULL),
 	handMinShadow_(NULL),
 	handHourShadow_(NULL),
+	handMap_(NULL),
 	weatherIcon_(NULL),
 	batteryIcon_(NULL),
 	sunsetIcon_(NULL),
 	sunriseIcon_(NULL),
+	weatherHitArea_(NULL),
 	animator_(NULL),
-	weatherTimer_(NULL),
-	locationTimeoutTimer_(NULL),
-	locationManager_(NULL),
-	weather_(new WeatherInfo()),
+	startupIdler_(NULL),
+	renderPostWatched_(false),
+	waitingFirstFrame_(false),
+	ambientChangeTime_(0),
+	initStartTime_(0),
 	width_(width),
 	height_(height),
-	listener_(NULL),
+	themeDir_(),
+	themed_(),
 	ambient_(false),
-	steps_(0),
-	lastSteps_(0),
-	lastTickDay_(-1),
-	lastTickMinute_(-1),
-	longitude_(0),
-	latitude_(0),
-	locationState_(-1),
-	locationStateRequested_(-1)
-{
+	hourDegree_(-1),
+	minDegree_(-1),
+	secDegree_(-1),
+	imageCacheSize_(0),
+	dateText_("txt.date"),
+	eventText_("txt.date.event"),
+	countdownText_("txt.date.countdown"),
+	weatherText_("txt.weather"),
+	weatherTempText_("txt.weather.temp"),
+	batteryText_("txt.battery.num"),
+	stepsText_("txt.steps.num"),
+	moonText_("txt.moon"),
+	controller_(this)
+{
+	for (ThemedImage& image: themed_) {
+		image.wanted = -1;
+		image.shown = -1;
+	}
 }
 
 Face::~Face()
 {
-	if (weatherTimer_) {
-		Timer::GetInstance().DeleteTimer(weatherTimer_);
-	}
-	if (locationTimeoutTimer_) {
-		Timer::GetInstance().DeleteTimer(locationTimeoutTimer_);
-	}
 	if (layout_) {
 		evas_object_del(layout_);
 	}
 	if (bg_) {
 		evas_object_del(bg_);
 	}
+	if (bgAmbient_) {
+		evas_object_del(bgAmbient_);
+	}
 	if (handSec_) {
 		evas_object_del(handSec_);
 	}
@@ -114,26 +83,33 @@ Face::~Face()
 	if (handHourShadow_) {
 		evas_object_del(handHourShadow_);
 	}
+	if (handMap_) {
+		evas_map_free(handMap_);
+	}
 	if (weatherIcon_) {
 		evas_object_del(weatherIcon_);
 	}
 	if (batteryIcon_) {
 		evas_object_del(batteryIcon_);
 	}
+	if (sunsetIcon_) {
+		evas_object_del(sunsetIcon_);
+	}
+	if (sunriseIcon_) {
+		evas_object_del(sunriseIcon_);
+	}
+	if (weatherHitArea_) {
+		evas_object_del(weatherHitArea_);
+	}
 	if (animator_) {
 		ecore_animator_del(animator_);
 	}
-	if (listener_) {
-		sensor_listener_unset_event_cb(listener_);
-		sensor_listener_stop(listener_);
-		sensor_destroy_listener(listener_);
+	if (renderPostWatched_) {
+		evas_event_callback_del_full(evas_object_evas_get(window_), EVAS_CALLBACK_RENDER_POST, Face::renderPostCallback, this);
 	}
-	if (locationManager_) {
-		location_manager_unset_service_state_changed_cb(locationManager_);
-		location_manager_stop(locationManager_);
-		location_manager_destroy(locationManager_);
+	if (startupIdler_) {
+		ecore_idler_del(startupIdler_);
 	}
-	delete weather_;
 }
 
 void Face::weatherClickCallback(void *data, Evas *e, Evas_Object *obj, void *event_info)
@@ -144,255 +120,287 @@ void Face::weatherClickCallback(void *data, Evas *e, Evas_Object *obj, void *eve
 
 void Face::onWeatherClick()
 {
-	if (!weather_) {
-		return;
-	}
-	weather_->ToggleScale();
-	updateWeatherText();
+	controller_.ToggleWeatherScale();
 }
 
 bool Face::Init()
 {
+	initStartTime_ = ecore_time_get();
+#if TRACE_INPUTS
+	openTrace();
+#endif
 	if (!createWindow()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to create window");
+		LOG_E("Failed to create window");
 		return false;
 	}
+	Diagnostics::LogScene("Window created", evas_object_evas_get(window_));
+	selectTheme();
 
 	if (!createBg()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to create background");
+		LOG_E("Failed to create background");
 		return false;
 	}
 
 	if (!createSublayoutParts()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to create sublayout parts");
+		LOG_E("Failed to create sublayout parts");
 		return false;
 	}
 
 	if (!createLayout()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to create layout");
+		LOG_E("Failed to create layout");
 		return false;
 	}
 
 	if (!createParts()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to create parts");
+		LOG_E("Failed to create parts");
 		return false;
 	}
 
-	animator_ = ecore_animator_add(Face::animatorCallback, this);
+	Diagnostics::LogScene("Scene created", evas_object_evas_get(window_));
+	LOG_I("Startup: scene ready in %.1f ms", (ecore_time_get() - initStartTime_) * 1000);
 
-	if (!setupListeners()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to setup listeners");
-		return false;
-	}
+	animator_ = ecore_animator_add(Face::animatorCallback, this);
+	loadQuietSchedule();
+	controller_.Init();
+	registerMemoryReleasers();
 
-	if (!setupLocation()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to setup location");
-		return false;
-	}
+	// Sensors and location are brought up once the first frame is on screen
+	waitingFirstFrame_ = true;
+	watchRenderPost();
 
 	return true;
 }
 
-int Face::updateLocation()
+void Face::renderPostCallback(void *data, Evas *e, void *eventInfo)
 {
-	double altitude;
-	time_t timestamp;
-	return location_manager_get_position(locationManager_, &altitude, &latitude_, &longitude_, &timestamp);
+	Face* face = (Face*)data;
+	face->onRenderPost();
 }
 
-void Face::updateWeatherText()
+void Face::watchRenderPost()
 {
-	if (!weather_ || !weather_->Ready()) {
+	if (renderPostWatched_) {
 		return;
 	}
-	char text[64] = { 0, };
-	weather_->GetString(text, sizeof(text));
-	elm_object_part_text_set(layout_, "txt.weather", text);
+	evas_event_callback_add(evas_object_evas_get(window_), EVAS_CALLBACK_RENDER_POST, Face::renderPostCallback, this);
+	renderPostWatched_ = true;
 }
 
-#define Q(x)  #x
-#define QUOTE(x)  Q(x)
-
-void Face::updateWeather()
+void Face::onRenderPost()
 {
-	WATCH_ERR("%s", "updw");
-	std::stringstream weatherUrlSS;
-	weatherUrlSS << "http://api.openweathermap.org/data/2.5/weather?lat=" << std::setprecision(3) << latitude_ << "&lon=" << longitude_ << "&APPID=" << QUOTE(WEATHER_TOKEN);
-	int err = 0;
-	auto json = CurlWrapper::Get(weatherUrlSS.str(), err);
-	if (json.empty()) {
-		WATCH_ERR("curl: %d", err);
-		return;
+	if (waitingFirstFrame_) {
+		onFirstFrame();
 	}
-	if (err != 0) {
-		WATCH_ERR("curl_e: %d", err);
+	if (ambientChangeTime_ > 0) {
+		onAmbientFrame();
 	}
+	// Nothing to wait for, don't get called for every frame
+	evas_event_callback_del_full(evas_object_evas_get(window_), EVAS_CALLBACK_RENDER_POST, Face::renderPostCallback, this);
+	renderPostWatched_ = false;
+}
 
-	bool res = weather_->FromJson(json.c_str());
-	if (res) {
-		updateWeatherText();
-
-		char imagePath[PATH_MAX] = { 0, };
-		data_get_resource_path(weather_->Icon(), imagePath, sizeof(imagePath));
-		elm_image_file_set(weatherIcon_, imagePath, NULL);
-
-		moveSunIcon(sunriseIcon_, weather_->Sunrise());
-		evas_object_show(sunriseIcon_);
-
-		moveSunIcon(sunsetIcon_, weather_->Sunset());
-		evas_object_show(sunsetIcon_);
-	} else {
-		WATCH_ERR("%s", "jsnerr");
-	}
-	dlog_print(DLOG_DEBUG, LOG_TAG, "Weather: %s", json.c_str());
+void Face::onAmbientFrame()
+{
+	double latency = ecore_time_get() - ambientChangeTime_;
+	ambientChangeTime_ = 0;
+	LOG_I("Ambient %s: frame out in %.1f ms", ambient_ ? "on" : "off", latency * 1000);
+	controller_.Events().Add(EventRing::EVENT_AMBIENT_LATENCY, ambient_, (int)(latency * 1000));
 }
 
-void Face::moveSunIcon(Evas_Object* icon, time_t time)
+void Face::onFirstFrame()
 {
-	struct tm* timeInfo = localtime(&time);
-	int degree = (timeInfo->tm_hour > 12 ? timeInfo->tm_hour - 12 : timeInfo->tm_hour) * HOUR_ANGLE;
-	degree += timeInfo->tm_min * HOUR_ANGLE / 60.0 - 90;
-	double rsin = sin(degree * M_PI / 180.0);
-	double rcos = cos(degree * M_PI / 180.0);
-	int x = (BASE_WIDTH / 2 - SUN_ICON_WIDTH / 2) * (1 + rcos);
-	int y = (BASE_HEIGHT / 2 - SUN_ICON_HEIGHT / 2) * (1 + rsin);
-	evas_object_move(icon, x, y);
+	waitingFirstFrame_ = false;
+	LOG_I("Startup: first frame in %.1f ms", (ecore_time_get() - initStartTime_) * 1000);
+	startupIdler_ = ecore_idler_add(Face::startupIdlerCallback, this);
 }
 
-void Face::locationStateCallback(location_service_state_e state, void *data)
+Eina_Bool Face::startupIdlerCallback(void *data)
 {
 	Face* face = (Face*)data;
-	face->onLocationState(state);
+	face->onStartupIdler();
+	return ECORE_CALLBACK_CANCEL;
 }
 
-void Face::onLocationState(location_service_state_e state)
+void Face::onStartupIdler()
 {
-	if (locationTimeoutTimer_) {
-		Timer::GetInstance().DeleteTimer(locationTimeoutTimer_);
-		locationTimeoutTimer_ = NULL;
+	startupIdler_ = NULL;
+
+	// Decoded ahead of the first ambient switch, which has a frame deadline
+	loadAsset(Theme::ASSET_BG_AMBIENT);
+
+	double start = ecore_time_get();
+	char logPath[PATH_MAX] = { 0, };
+	data_get_data_path(STEP_LOG_FILE, logPath, sizeof(logPath));
+	if (!controller_.SetupSensors(logPath)) {
+		LOG_E("Failed to setup sensors. Steps disabled");
 	}
-	locationState_ = state;
-	dlog_print(DLOG_DEBUG, LOG_TAG, "Location state change: %d", state);
-	WATCH_ERR("CB %d", state);
-	if (state == LOCATIONS_SERVICE_ENABLED) {
-		int ret = updateLocation();
-		if (ret != APP_ERROR_NONE) {
-			dlog_print(DLOG_ERROR, LOG_TAG, "updateLocation failed: %s", get_error_message(ret));
-			WATCH_ERR("loc: %s", get_error_message(ret));
-			return;
-		}
-		updateWeather();
-		requestLocationServiceState(LOCATIONS_SERVICE_DISABLED);
+	double sensorsTime = ecore_time_get() - start;
+
+	start = ecore_time_get();
+	if (!controller_.SetupLocation()) {
+		LOG_E("Failed to setup location. Weather for the last position only");
 	}
-}
+	double locationTime = ecore_time_get() - start;
 
-bool Face::weatherTimerFunc(void* data)
-{
-	Face* face = (Face*)data;
-	face->onWeatherTimer();
-	return true;
+	LOG_I("Startup: sensors %.1f ms, location %.1f ms, total %.1f ms",
+			sensorsTime * 1000, locationTime * 1000, (ecore_time_get() - initStartTime_) * 1000);
 }
 
-void Face::onWeatherTimer()
+void Face::PlaceSunIcons(const DayPlan& plan)
 {
-	WATCH_ERR("tmr %d %d", locationState_, locationStateRequested_);
-
-	dlog_print(DLOG_DEBUG, LOG_TAG, "onWeatherTimer. State: %d Requested: %d", locationState_, locationStateRequested_);
-	if (locationState_ == LOCATIONS_SERVICE_DISABLED) {
-		requestLocationServiceState(LOCATIONS_SERVICE_ENABLED);
-	} else {
-		requestLocationServiceState(LOCATIONS_SERVICE_DISABLED);
+	if (!plan.Ready()) {
+		evas_object_hide(sunriseIcon_);
+		evas_object_hide(sunsetIcon_);
+		return;
 	}
-	WATCH_ERR("%s", "tmrend");
+	loadAsset(Theme::ASSET_SUNRISE);
+	loadAsset(Theme::ASSET_SUNSET);
+	// Markers are laid out for SUN_ICON_WIDTH icons, other sizes keep the centre
+	int offset = (SUN_ICON_WIDTH - theme_.SunIconSize()) / 2;
+	evas_object_move(sunriseIcon_, display_.X(plan.SunriseMarker().x + offset), display_.Y(plan.SunriseMarker().y + offset));
+	evas_object_show(sunriseIcon_);
+	evas_object_move(sunsetIcon_, display_.X(plan.SunsetMarker().x + offset), display_.Y(plan.SunsetMarker().y + offset));
+	evas_object_show(sunsetIcon_);
 }
 
 void Face::PauseAnimator()
 {
-	ecore_animator_freeze(animator_);
+	controller_.Pause();
 }
 
 void Face::ResumeAnimator()
 {
-	ecore_animator_thaw(animator_);
+	controller_.Resume();
 }
 
-Eina_Bool Face::animatorCallback(void *data)
+void Face::LowBattery()
 {
-	Face* face = (Face*)data;
-	if (!face->onAnimator()) {
-		return EINA_FALSE;
-	}
-	return EINA_TRUE;
+	controller_.LowBattery();
 }
 
-bool Face::onAnimator()
+void Face::LowMemory(app_event_low_memory_status_e status)
 {
-	watch_time_h time;
-	int ret = watch_time_get_current_time(&time);
-	if (ret != APP_ERROR_NONE) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to get current time. err = %d", ret);
-		return true;
+	switch (status) {
+	case APP_EVENT_LOW_MEMORY_SOFT_WARNING:
+		memory_.Raise(MemoryPressure::TIER_SPRITES);
+		break;
+	case APP_EVENT_LOW_MEMORY_HARD_WARNING:
+		memory_.Raise(MemoryPressure::TIER_NETWORK);
+		break;
+	default:
+		memory_.Relieve();
+		break;
 	}
-	moveHands(time);
+}
 
-	watch_time_delete(time);
-	return true;
+void Face::registerMemoryReleasers()
+{
+	memory_.Register(MemoryPressure::TIER_CACHES, "caches", memoryCallback<&Face::releaseCaches>, memoryCallback<&Face::restoreCaches>, this);
+	memory_.Register(MemoryPressure::TIER_SPRITES, "sprites", memoryCallback<&Face::releaseSprites>, nullptr, this);
+	memory_.Register(MemoryPressure::TIER_SPRITES, "background", memoryCallback<&Face::releaseBg>, nullptr, this);
+	memory_.Register(MemoryPressure::TIER_TABLES, "step log", memoryCallback<&Face::releaseTables>, nullptr, this);
+	memory_.Register(MemoryPressure::TIER_NETWORK, "workers", memoryCallback<&Face::releaseWorkers>, nullptr, this);
 }
 
-void Face::listenerCallback(sensor_h sensorHanlder, sensor_event_s* event, void* data)
+void Face::releaseCaches()
 {
-	Face* face = (Face*)data;
-	face->onListener(sensorHanlder, event);
+	Evas* evas = evas_object_evas_get(window_);
+	// No caching of unused images until the pressure is over
+	imageCacheSize_ = evas_image_cache_get(evas);
+	evas_image_cache_set(evas, 0);
+	evas_image_cache_flush(evas);
+	evas_font_cache_flush(evas);
+	edje_file_cache_flush();
+	edje_collection_cache_flush();
+	evas_render_idle_flush(evas);
 }
 
-void Face::onListener(sensor_h sensorHanlder, sensor_event_s* event)
+void Face::restoreCaches()
 {
-	// Assume pedometer. Extend later.
-	steps_ = (int)event->values[0];
+	evas_image_cache_set(evas_object_evas_get(window_), imageCacheSize_);
 }
 
-void Face::Tick(watch_time_h time)
+void Face::releaseSprites()
 {
-	Timer::GetInstance().Tick();
-	bool resetSensorCounters = false;
-	int currDay = 0;
-	int minute = 0;
-	watch_time_get_day(time, &currDay);
-	watch_time_get_minute(time, &minute);
-
-	if (lastTickDay_ == -1 || currDay != lastTickDay_ || steps_ < lastSteps_) {
-		resetSensorCounters = true;
-	}
-	lastTickDay_ = currDay;
-	if (resetSensorCounters) {
-		sensor_event_s event;
-		int res = sensor_listener_read_data(listener_, &event);
-		if (res == SENSOR_ERROR_NONE) {
-			lastSteps_ = event.values[0];
-			steps_ = lastSteps_;
-			dlog_print(DLOG_INFO, LOG_TAG, "Counters reset");
-		} else {
-			lastTickDay_ = -1;
-			dlog_print(DLOG_ERROR, LOG_TAG, "Failed resetting last counters");
-		}
+	// The sun icons are hidden without a position, PlaceSunIcons loads them again
+	if (!controller_.GetDayPlan().Ready()) {
+		dropAsset(Theme::ASSET_SUNRISE);
+		dropAsset(Theme::ASSET_SUNSET);
 	}
+}
 
-	moveHands(time);
-	if (lastTickMinute_ != minute) {
-		lastTickMinute_ = minute;
-		updateTextFields();
-		updateDate(time);
+void Face::releaseBg()
+{
+	// The hidden background is loaded again by showBg, at the cost of a slow switch
+	if (!evas_object_visible_get(bg_)) {
+		dropAsset(Theme::ASSET_BG);
+	} else if (!evas_object_visible_get(bgAmbient_)) {
+		dropAsset(Theme::ASSET_BG_AMBIENT);
 	}
 }
 
-bool Face::ToggleAmbient(bool ambient)
+void Face::releaseTables()
 {
-	ambient_ = ambient;
+	controller_.TrimTables();
+}
 
-	if (ambient) {
+void Face::releaseWorkers()
+{
+	// Threads come back with the next weather request
+	if (!WorkerPool::GetInstance().Trim()) {
+		LOG_D("Workers busy, kept");
+	}
+}
+
+void Face::SetAnimating(bool animating)
+{
+	if (!animator_) {
+		return;
+	}
+	if (animating) {
+		ecore_animator_thaw(animator_);
+	} else {
+		ecore_animator_freeze(animator_);
+	}
+}
+
+void Face::ShowSecondHand(bool shown)
+{
+	if (shown) {
+		loadAsset(Theme::ASSET_HAND_SEC);
+		loadAsset(Theme::ASSET_HAND_SEC_SHADOW);
+		evas_object_show(handSec_);
+		evas_object_show(handsSecShadow_);
+	} else {
 		evas_object_hide(handSec_);
 		evas_object_hide(handsSecShadow_);
+	}
+}
 
+Eina_Bool Face::animatorCallback(void *data)
+{
+	Face* face = (Face*)data;
+	face->controller_.Frame();
+	return EINA_TRUE;
+}
+
+void Face::Tick(watch_time_h time)
+{
+	time_t now = 0;
+	int msec = 0;
+	watch_time_get_utc_timestamp(time, &now);
+	watch_time_get_millisecond(time, &msec);
+	controller_.Tick(now, msec);
+}
+
+void Face::ToggleAmbient(bool ambient)
+{
+	ambientChangeTime_ = ecore_time_get();
+	watchRenderPost();
+	ambient_ = ambient;
+	showBg();
+
+	if (ambient) {
 		evas_object_color_set(handHour_, 150, 150, 150, 255);
 		evas_object_color_set(handMin_, 150, 150, 150, 255);
 		evas_object_color_set(weatherIcon_, 150, 150, 150, 255);
@@ -402,9 +410,6 @@ bool Face::ToggleAmbient(bool ambient)
 
 		edje_color_class_set("dimmable", 100, 100, 100, 255, 100, 100, 100, 255, 100, 100, 100, 255);
 	} else {
-		evas_object_show(handSec_);
-		evas_object_show(handsSecShadow_);
-
 		evas_object_color_set(handHour_, 255, 255, 255, 255);
 		evas_object_color_set(handMin_, 255, 255, 255, 255);
 		evas_object_color_set(weatherIcon_, 255, 255, 255, 255);
@@ -414,104 +419,127 @@ bool Face::ToggleAmbient(bool ambient)
 
 		edje_color_class_set("dimmable", 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255);
 	}
-
-	if (!setBg()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed changing background on ambient change");
-		return false;
-	}
-
-	return true;
+	controller_.SetAmbient(ambient);
 }
 
 bool Face::createWindow()
 {
 	int ret = watch_app_get_elm_win(&window_);
 	if (ret != APP_ERROR_NONE) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "failed to get watch window. err = %d", ret);
+		LOG_E("failed to get watch window. err = %d", ret);
 		return false;
 	}
 	evas_object_resize(window_, width_, height_);
 	evas_object_show(window_);
+	display_.Select(width_, height_, imagesAvailable);
 
 	return true;
 }
 
+bool Face::imagesAvailable(const char* images)
+{
+	char path[PATH_MAX] = { 0, };
+	data_get_resource_path(images, path, sizeof(path));
+	return access(path, R_OK | X_OK) == 0;
+}
+
 bool Face::createBg()
 {
-	bg_ = elm_bg_add(window_);
-	if (!bg_) {
+	Evas* evas = evas_object_evas_get(window_);
+	int x = display_.Left();
+	int y = display_.Top();
+	int size = display_.Size();
+	bg_ = evas_object_image_filled_add(evas);
+	bgAmbient_ = evas_object_image_filled_add(evas);
+	if (!bg_ || !bgAmbient_) {
 		return false;
 	}
-	elm_bg_option_set(bg_, ELM_BG_OPTION_CENTER);
-
-	evas_object_move(bg_, 0, 0);
-	evas_object_resize(bg_, width_, height_);
-	evas_object_show(bg_);
+	evas_object_move(bg_, x, y);
+	evas_object_resize(bg_, size, size);
+	evas_object_move(bgAmbient_, x, y);
+	evas_object_resize(bgAmbient_, size, size);
 
-	if (!setBg()) {
+	themed_[Theme::ASSET_BG].object = bg_;
+	themed_[Theme::ASSET_BG_AMBIENT].object = bgAmbient_;
+	// The ambient one follows once the face is up, see onStartupIdler
+	if (!loadAsset(Theme::ASSET_BG)) {
 		return false;
 	}
+	showBg();
 
-	layout_ = elm_layout_add(bg_);
+	layout_ = elm_layout_add(window_);
 
 	return true;
 }
 
-bool Face::setBg()
+void Face::showBg()
 {
-	char path[PATH_MAX];
-
-	if (ambient_) {
-		data_get_resource_path(IMAGE_BG_BLACK, path, sizeof(path));
-	} else {
-		data_get_resource_path(IMAGE_BG, path, sizeof(path));
+	if (ambient_ && loadAsset(Theme::ASSET_BG_AMBIENT)) {
+		evas_object_show(bgAmbient_);
+		evas_object_hide(bg_);
+		return;
 	}
+	loadAsset(Theme::ASSET_BG);
+	// Without the ambient image the normal one stands in, dimmed
+	int level = ambient_ ? 60 : 255;
+	evas_object_color_set(bg_, level, level, level, 255);
+	evas_object_show(bg_);
+	evas_object_hide(bgAmbient_);
+}
 
-	int ret = elm_bg_file_set(bg_, path, NULL);
-	if (ret != EINA_TRUE) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to set the background image");
-		evas_object_del(bg_);
+bool Face::createLayout()
+{
+	if (layout_ == NULL || !loadLayout()) {
+		LOG_E("Failed to create layout from edc");
 		return false;
 	}
+	evas_object_size_hint_weight_set(layout_, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+	evas_object_move(layout_, display_.Left(), display_.Top());
+	evas_object_resize(layout_, display_.Size(), display_.Size());
+	evas_object_show(layout_);
+
 	return true;
 }
 
-bool Face::createLayout()
+bool Face::loadLayout()
 {
 	char edjPath[PATH_MAX] = { 0, };
-
-	data_get_resource_path(EDJ_FILE, edjPath, sizeof(edjPath));
-	elm_layout_file_set(layout_, edjPath, "omaha");
-	evas_object_size_hint_weight_set(layout_, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
-	evas_object_show(layout_);
-
-	if (layout_ == NULL) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to create layout from edc");
+	themeFile(theme_.Layout(), edjPath, sizeof(edjPath));
+	if (!elm_layout_file_set(layout_, edjPath, theme_.Group())) {
+		LOG_E("Failed to load layout %s", edjPath);
 		return false;
 	}
-
-	evas_object_resize(layout_, BASE_WIDTH, BASE_HEIGHT);
-	evas_object_show(layout_);
-
+	// The edc is in base coordinates, its parts with scale: 1 follow the dial.
+	// Through elm rather than on the edje object, elm reapplies its own scale
+	// on theme changes.
+	elm_object_scale_set(layout_, display_.Size() / (double)BASE_WIDTH);
+	// A new layout starts out with the texts of its edc
+	invalidateTexts();
+	controller_.InvalidateAll();
 	return true;
 }
 
-Evas_Object* Face::createPart(const char* path, int x, int y, int width, int height)
+Evas_Object* Face::createPart(const char* path, int x, int y, int width, int height, bool async/* = false*/)
 {
-	Evas_Object* part = elm_image_add(bg_);
+	// Plain Evas images: none of the elm_image smart object overhead
+	Evas_Object* part = evas_object_image_filled_add(evas_object_evas_get(window_));
 	if (!part) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to add hand image");
+		LOG_E("Failed to add hand image");
 		return NULL;
 	}
 
-	char imagePath[PATH_MAX] = { 0, };
-	data_get_resource_path(path, imagePath, sizeof(imagePath));
-	Eina_Bool ret = elm_image_file_set(part, imagePath, NULL);
-	if (ret != EINA_TRUE) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed to set hand image %s", path);
+	if (!setImageFile(part, path, async)) {
 		evas_object_del(part);
 		return NULL;
 	}
+#ifdef _DEBUG
+	int imageWidth = 0;
+	int imageHeight = 0;
+	evas_object_image_size_get(part, &imageWidth, &imageHeight);
+	if (display_.Native() && (imageWidth != width || imageHeight != height)) {
+		LOG_W("Image %s is %dx%d, scaled to %dx%d on every draw", path, imageWidth, imageHeight, width, height);
+	}
+#endif
 
 	evas_object_move(part, x, y);
 	evas_object_resize(part, width, height);
@@ -520,12 +548,41 @@ Evas_Object* Face::createPart(const char* path, int x, int y, int width, int hei
 	return part;
 }
 
+bool Face::setImageFile(Evas_Object* image, const char* path, bool async/* = false*/)
+{
+	char imagePath[PATH_MAX] = { 0, };
+	char setPath[PATH_MAX] = { 0, };
+	data_get_resource_path(display_.ImagePath(path, setPath, sizeof(setPath)), imagePath, sizeof(imagePath));
+	return loadImage(image, imagePath, async);
+}
+
+bool Face::loadImage(Evas_Object* image, const char* file, bool async)
+{
+#ifdef _DEBUG
+	if (!WorkerPool::OnMainThread()) {
+		LOG_E("Image %s set off the main thread", file);
+	}
+#endif
+	Stats::Add(Stats::IMAGE_LOADS);
+	evas_object_image_file_set(image, file, NULL);
+	Evas_Load_Error err = evas_object_image_load_error_get(image);
+	if (err != EVAS_LOAD_ERROR_NONE) {
+		LOG_E("Failed to load image %s: %d", file, err);
+		return false;
+	}
+	if (async) {
+		// Decode in a background thread, the image shows up once it's ready
+		evas_object_image_preload(image, EINA_FALSE);
+	}
+	return true;
+}
+
 bool Face::createSublayoutParts()
 {
-	if (!(weatherIcon_ = createPart("images/01d.png", 220, 50, 50, 50))) {
+	if (!(weatherIcon_ = createPart("images/01d.png", display_.X(220), display_.Y(50), display_.Scale(50), display_.Scale(50), true))) {
 		return false;
 	}
-	if (!(batteryIcon_ = createPart("images/b100.png", 270, 180, 40, 20))) {
+	if (!(batteryIcon_ = createPart("images/b100.png", display_.X(270), display_.Y(180), display_.Scale(40), display_.Scale(20), true))) {
 		return false;
 	}
 	return true;
@@ -533,283 +590,404 @@ bool Face::createSublayoutParts()
 
 bool Face::createParts()
 {
-	if (!(handHourShadow_ = createPart(IMAGE_HANDS_HOUR_SHADOW, (BASE_WIDTH / 2) - (HANDS_HOUR_WIDTH / 2), HANDS_HOUR_SHADOW_PADDING, HANDS_HOUR_WIDTH, HANDS_HOUR_HEIGHT))) {
+	// Bottom to top, each shadow under its hand
+	if (!(handHourShadow_ = createThemedPart(Theme::ASSET_HAND_HOUR_SHADOW))) {
 		return false;
 	}
-	if (!(handHour_= createPart(IMAGE_HANDS_HOUR, (BASE_WIDTH / 2) - (HANDS_HOUR_WIDTH / 2), 0, HANDS_HOUR_WIDTH, HANDS_HOUR_HEIGHT))) {
+	if (!(handHour_ = createThemedPart(Theme::ASSET_HAND_HOUR))) {
 		return false;
 	}
-	if (!(handMinShadow_ = createPart(IMAGE_HANDS_MIN_SHADOW, (BASE_WIDTH / 2) - (HANDS_MIN_WIDTH / 2), HANDS_MIN_SHADOW_PADDING, HANDS_MIN_WIDTH, HANDS_MIN_HEIGHT))) {
+	if (!(handMinShadow_ = createThemedPart(Theme::ASSET_HAND_MIN_SHADOW))) {
 		return false;
 	}
-	if (!(handMin_ = createPart(IMAGE_HANDS_MIN, (BASE_WIDTH / 2) - (HANDS_MIN_WIDTH / 2), 0, HANDS_MIN_WIDTH, HANDS_MIN_HEIGHT))) {
+	if (!(handMin_ = createThemedPart(Theme::ASSET_HAND_MIN))) {
 		return false;
 	}
-	if (!(handsSecShadow_ = createPart(IMAGE_HANDS_SEC_SHADOW, (BASE_WIDTH / 2) - (HANDS_SEC_WIDTH / 2), HANDS_SEC_SHADOW_PADDING, HANDS_SEC_WIDTH, HANDS_SEC_HEIGHT))) {
+	if (!(handsSecShadow_ = createThemedPart(Theme::ASSET_HAND_SEC_SHADOW))) {
 		return false;
 	}
-	if (!(handSec_ = createPart(IMAGE_HANDS_SEC, (BASE_WIDTH / 2) - (HANDS_SEC_WIDTH / 2), 0, HANDS_SEC_WIDTH, HANDS_SEC_HEIGHT))) {
+	if (!(handSec_ = createThemedPart(Theme::ASSET_HAND_SEC))) {
 		return false;
 	}
-	if (!(sunsetIcon_ = createPart("images/sunset.png", 0, 0, SUN_ICON_WIDTH, SUN_ICON_HEIGHT))) {
+	if (!(sunsetIcon_ = createThemedPart(Theme::ASSET_SUNSET))) {
 		return false;
 	}
-	if (!(sunriseIcon_ = createPart("images/sunrise.png", 0, 0, SUN_ICON_WIDTH, SUN_ICON_HEIGHT))) {
+	if (!(sunriseIcon_ = createThemedPart(Theme::ASSET_SUNRISE))) {
 		return false;
 	}
+	placeParts();
+	if (!loadAsset(Theme::ASSET_HAND_HOUR) || !loadAsset(Theme::ASSET_HAND_MIN)) {
+		return false;
+	}
+	// Shadows are decoration, a theme without them still tells the time
+	loadAsset(Theme::ASSET_HAND_HOUR_SHADOW);
+	loadAsset(Theme::ASSET_HAND_MIN_SHADOW);
+	evas_object_show(handHourShadow_);
+	evas_object_show(handHour_);
+	evas_object_show(handMinShadow_);
+	evas_object_show(handMin_);
+	// The second hand is up to the power tier, see FaceController::Init
+	evas_object_hide(handSec_);
+	evas_object_hide(handsSecShadow_);
 	evas_object_hide(sunsetIcon_);
 	evas_object_hide(sunriseIcon_);
 
-	Evas_Object* tb = elm_entry_add(bg_);
-	evas_object_move(tb, 202, 68);
-	evas_object_resize(tb, 100, 80);
-	evas_object_show(tb);
-	evas_object_event_callback_add(tb, EVAS_CALLBACK_MOUSE_UP, Face::weatherClickCallback, this);
+	// Invisible hit area over the weather text
+	weatherHitArea_ = evas_object_rectangle_add(evas_object_evas_get(window_));
+	if (!weatherHitArea_) {
+		return false;
+	}
+	evas_object_color_set(weatherHitArea_, 0, 0, 0, 0);
+	evas_object_move(weatherHitArea_, display_.X(202), display_.Y(68));
+	evas_object_resize(weatherHitArea_, display_.Scale(100), display_.Scale(80));
+	evas_object_show(weatherHitArea_);
+	evas_object_event_callback_add(weatherHitArea_, EVAS_CALLBACK_MOUSE_UP, Face::weatherClickCallback, this);
 
 	return true;
 }
 
-bool Face::setupListeners()
+Evas_Object* Face::createThemedPart(Theme::Asset asset)
 {
-	sensor_h sensorHanlder;
-	sensor_get_default_sensor(SENSOR_HUMAN_PEDOMETER, &sensorHanlder);
+	// Nothing is decoded until the part is shown, see loadAsset
+	Evas_Object* part = evas_object_image_filled_add(evas_object_evas_get(window_));
+	if (!part) {
+		LOG_E("Failed to add %s image", Theme::AssetName(asset));
+		return NULL;
+	}
+	themed_[asset].object = part;
+	return part;
+}
 
-	sensor_create_listener(sensorHanlder, &listener_);
-	sensor_listener_set_option(listener_, SENSOR_OPTION_ALWAYS_ON);
-	sensor_listener_set_event_cb(listener_, 1000, Face::listenerCallback, this);
-	sensor_listener_start(listener_);
+void Face::placeParts()
+{
+	placeHand(handHour_, handHourShadow_, Theme::HAND_HOUR);
+	placeHand(handMin_, handMinShadow_, Theme::HAND_MIN);
+	placeHand(handSec_, handsSecShadow_, Theme::HAND_SEC);
+	int sunIconSize = display_.Scale(theme_.SunIconSize());
+	evas_object_resize(sunsetIcon_, sunIconSize, sunIconSize);
+	evas_object_resize(sunriseIcon_, sunIconSize, sunIconSize);
+}
 
-	return true;
+void Face::placeHand(Evas_Object* hand, Evas_Object* shadow, Theme::Hand geometry)
+{
+	// Hand images are centred on the dial and rotate around its centre
+	const Theme::HandGeometry& size = theme_.GetHand(geometry);
+	int x = display_.X((BASE_WIDTH - size.width) / 2);
+	int y = (BASE_HEIGHT - size.height) / 2;
+	evas_object_move(hand, x, display_.Y(y));
+	evas_object_resize(hand, display_.Scale(size.width), display_.Scale(size.height));
+	evas_object_move(shadow, x, display_.Y(y + size.shadowPadding));
+	evas_object_resize(shadow, display_.Scale(size.width), display_.Scale(size.height));
 }
 
-bool Face::setupLocation()
+bool Face::SetTheme(const char* name)
 {
-	int ret = 0;
-	ret = location_manager_create(LOCATIONS_METHOD_WPS, &locationManager_);
-	if (ret == LOCATIONS_ERROR_NOT_SUPPORTED) {
-		WATCH_ERR("%s", "not sup");
-		ret = location_manager_create(LOCATIONS_METHOD_HYBRID, &locationManager_);
-	}
-	if (ret != LOCATIONS_ERROR_NONE) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "location_manager_create failed: %s", get_error_message(ret));
+	Theme theme;
+	char dir[PATH_MAX] = { 0, };
+	if (!findTheme(name, &theme, dir, sizeof(dir))) {
+		LOG_E("Theme %s not found", name);
 		return false;
 	}
-	ret = location_manager_set_service_state_changed_cb(locationManager_, Face::locationStateCallback, this);
-	if (ret != LOCATIONS_ERROR_NONE) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "location_manager_set_service_state_changed_cb failed: %s", get_error_message(ret));
-		return false;
+	char oldLayout[PATH_MAX] = { 0, };
+	char newLayout[PATH_MAX] = { 0, };
+	themeFile(theme_.Layout(), oldLayout, sizeof(oldLayout));
+	bool groupChanged = strcmp(theme.Group(), theme_.Group()) != 0;
+	theme_ = theme;
+	memcpy(themeDir_, dir, sizeof(themeDir_));
+	themeFile(theme_.Layout(), newLayout, sizeof(newLayout));
+	LOG_I("Theme: %s", theme_.Name());
+
+	// Objects, layout and texts stay, only what the themes don't share is loaded
+	wantAssets();
+	placeParts();
+	showBg();
+	loadAsset(Theme::ASSET_BG_AMBIENT);
+	PlaceSunIcons(controller_.GetDayPlan());
+	if ((groupChanged || strcmp(oldLayout, newLayout) != 0) && !loadLayout()) {
+		LOG_E("Theme %s has no usable layout", name);
+	}
+	// Rotated again from the new geometry
+	hourDegree_ = -1;
+	minDegree_ = -1;
+	secDegree_ = -1;
+	controller_.Frame();
+
+	char path[PATH_MAX] = { 0, };
+	data_get_data_path(THEME_SELECTED_FILE, path, sizeof(path));
+	FILE* file = fopen(path, "w");
+	if (!file) {
+		LOG_E("Failed to save theme selection to %s", path);
+		return true;
 	}
+	fprintf(file, "%s\n", name);
+	fclose(file);
+	return true;
+}
 
-	if (!requestLocationServiceState(LOCATIONS_SERVICE_ENABLED)) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "requestLocationServiceState failed");
+bool Face::findTheme(const char* name, Theme* theme, char* dir, size_t len)
+{
+	// Names come from other apps, they only pick a directory under THEMES_DIR
+	if (name[0] == '\0' || name[0] == '.' || strchr(name, '/')) {
 		return false;
 	}
+	char relative[PATH_MAX] = { 0, };
+	snprintf(relative, sizeof(relative), THEMES_DIR "/%s", name);
+	// Installed packs first, then the ones shipped with the face
+	for (int installed = 1; installed >= 0; --installed) {
+		if (installed) {
+			data_get_data_path(relative, dir, len);
+		} else {
+			data_get_resource_path(relative, dir, len);
+		}
+		char manifest[PATH_MAX] = { 0, };
+		snprintf(manifest, sizeof(manifest), "%s/" THEME_MANIFEST, dir);
+		Theme candidate;
+		if (candidate.Load(manifest)) {
+			*theme = candidate;
+			return true;
+		}
+	}
+	return false;
+}
 
-	if (!weatherTimer_) {
-		weatherTimer_ = Timer::GetInstance().AddTimer(10 * 60, weatherTimerFunc, this);
+bool Face::SetQuietSchedule(const char* text)
+{
+	QuietMode::Schedule schedule;
+	if (!QuietMode::ParseSchedule(text, &schedule)) {
+		LOG_E("Bad quiet schedule %s", text);
+		return false;
 	}
+	char str[64];
+	QuietMode::FormatSchedule(schedule, str, sizeof(str));
+	LOG_I("Quiet schedule: %s", str);
+	controller_.SetQuietSchedule(schedule);
 
+	char path[PATH_MAX] = { 0, };
+	data_get_data_path(QUIET_SCHEDULE_FILE, path, sizeof(path));
+	FILE* file = fopen(path, "w");
+	if (!file) {
+		LOG_E("Failed to save quiet schedule to %s", path);
+		return true;
+	}
+	fprintf(file, "%s\n", str);
+	fclose(file);
 	return true;
 }
 
-void Face::rotateHand(Evas_Object *hand, double degree, Evas_Coord cx, Evas_Coord cy)
+void Face::loadQuietSchedule()
 {
-	Evas_Map *m = NULL;
-
-	m = evas_map_new(4);
-	evas_map_util_points_populate_from_object(m, hand);
-	evas_map_util_rotate(m, degree, cx, cy);
-	evas_object_map_set(hand, m);
-	evas_object_map_enable_set(hand, EINA_TRUE);
-	evas_map_free(m);
+	char path[PATH_MAX] = { 0, };
+	data_get_data_path(QUIET_SCHEDULE_FILE, path, sizeof(path));
+	FILE* file = fopen(path, "r");
+	if (!file) {
+		return;
+	}
+	char text[64] = { 0, };
+	if (fgets(text, sizeof(text), file)) {
+		text[strcspn(text, "\r\n")] = '\0';
+		QuietMode::Schedule schedule;
+		if (QuietMode::ParseSchedule(text, &schedule)) {
+			controller_.SetQuietSchedule(schedule);
+		} else {
+			LOG_W("Saved quiet schedule %s can't be parsed, using the default", text);
+		}
+	}
+	fclose(file);
 }
 
-void Face::moveHands(watch_time_h time)
+void Face::selectTheme()
 {
-	int msec = 0;
-	int sec = 0;
-	int min = 0;
-	int hour = 0;
-	double degree = 0.0f;
-
-	watch_time_get_hour(time, &hour);
-	watch_time_get_minute(time, &min);
-	watch_time_get_second(time, &sec);
-	watch_time_get_millisecond(time, &msec);
-
-	degree = hour * HOUR_ANGLE;
-	degree += min * HOUR_ANGLE / 60.0;
-	rotateHand(handHour_, degree, (BASE_WIDTH / 2), (BASE_HEIGHT / 2));
-	rotateHand(handHourShadow_, degree, (BASE_WIDTH / 2), (BASE_HEIGHT / 2) + HANDS_HOUR_SHADOW_PADDING);
-
-	degree = min * MIN_ANGLE;
-	degree += sec * MIN_ANGLE / 60.0;
-	rotateHand(handMin_, degree, (BASE_WIDTH / 2), (BASE_HEIGHT / 2));
-	rotateHand(handMinShadow_, degree, (BASE_WIDTH / 2), (BASE_HEIGHT / 2) + HANDS_MIN_SHADOW_PADDING);
-
-	degree = sec * SEC_ANGLE;
-	degree += msec * SEC_ANGLE / 1000.0;
-	rotateHand(handSec_, degree, (BASE_WIDTH / 2), (BASE_HEIGHT / 2));
-	rotateHand(handsSecShadow_, degree,  (BASE_WIDTH / 2), (BASE_HEIGHT / 2) + HANDS_SEC_SHADOW_PADDING);
+	char name[Theme::maxName] = THEME_DEFAULT;
+	char path[PATH_MAX] = { 0, };
+	data_get_data_path(THEME_SELECTED_FILE, path, sizeof(path));
+	FILE* file = fopen(path, "r");
+	if (file) {
+		if (fgets(name, sizeof(name), file)) {
+			name[strcspn(name, "\r\n")] = '\0';
+		}
+		fclose(file);
+	}
+	if (!findTheme(name, &theme_, themeDir_, sizeof(themeDir_))) {
+		LOG_W("Theme %s not found, using the built-in look", name);
+		theme_ = Theme();
+		themeDir_[0] = '\0';
+	}
+	LOG_I("Theme: %s", theme_.Name());
+	wantAssets();
 }
 
-void Face::updateDate(watch_time_h time)
+void Face::themeFile(const char* file, char* out, size_t len)
 {
-	char fullDateStr[256];
-	int hour, minute, month, day, weekDay;
-	watch_time_get_month(time, &month);
-	watch_time_get_day(time, &day);
-	watch_time_get_day_of_week(time, &weekDay);
-	sprintf(fullDateStr, "%s %s %d", Weekdays[weekDay], Months[month], day);
-	if (!weather_ || !weather_->Ready()) {
-		elm_object_part_text_set(layout_, "txt.date", fullDateStr);
+	if (Theme::InPack(file)) {
+		snprintf(out, len, "%s/%s", themeDir_, file + 2);
 		return;
 	}
-	time_t sunset = weather_->Sunset();
-	struct tm sunsetInfo;
-	sunsetInfo = *localtime(&sunset);
-	time_t sunrise = weather_->Sunrise();
-	struct tm sunriseInfo;
-	sunriseInfo = *localtime(&sunrise);
-	bool beforeSunrise = false;
-	watch_time_get_hour24(time, &hour);
-	watch_time_get_minute(time, &minute);
-	if (hour > sunsetInfo.tm_hour || hour < sunriseInfo.tm_hour) {
-		beforeSunrise = true;
-	} else if (hour == sunsetInfo.tm_hour && minute > sunsetInfo.tm_min) {
-		beforeSunrise = true;
-	} else if (hour == sunriseInfo.tm_hour && minute <= sunriseInfo.tm_min) {
-		beforeSunrise = true;
-	}
-	struct tm* nextEvent = beforeSunrise ? &sunriseInfo : &sunsetInfo;
-
-	int dHour = nextEvent->tm_hour - hour;
-	int dMinute = nextEvent->tm_min - minute;
-	if (dMinute < 0) {
-		dMinute += 60;
-		--dHour;
-	}
-	if (dHour < 0) {
-		dHour += 24;
-	}
-
-	const char* nextEventStr = beforeSunrise ? "Sunrise" : "Sunset";
-	char fullNextEventStr[128] = {0};
-	if (dHour == 0 && dMinute == 0) {
-		sprintf(fullNextEventStr, "<br/>%s is now", nextEventStr);
-	} else {
-		sprintf(fullNextEventStr, "<br/>%s in<br/>%.2d:%.2d", nextEventStr, dHour, dMinute);
-	}
-	strcat(fullDateStr, fullNextEventStr);
-	elm_object_part_text_set(layout_, "txt.date", fullDateStr);
+	char setPath[PATH_MAX] = { 0, };
+	data_get_resource_path(display_.ImagePath(file, setPath, sizeof(setPath)), out, len);
 }
 
-void Face::updateTextFields()
+void Face::wantAssets()
 {
-	int batteryPercent = 0;
-
-	int res = device_battery_get_percent(&batteryPercent);
-	if (res) {
-		batteryPercent = 0;
+	for (int i = 0; i < Theme::ASSETS_NUM; ++i) {
+		char file[PATH_MAX] = { 0, };
+		themeFile(theme_.File((Theme::Asset)i), file, sizeof(file));
+		// Acquired before the old one is released, a file both themes use keeps its entry
+		ThemedImage& image = themed_[i];
+		int wanted = assets_.Acquire(file);
+		assets_.Release(image.wanted);
+		image.wanted = wanted;
+		// Images on screen switch now, the rest when they're next shown
+		if (image.object && evas_object_visible_get(image.object)) {
+			loadAsset((Theme::Asset)i);
+		}
 	}
+	LOG_D("%d theme assets in use", assets_.Size());
+}
 
-	char imagePath[PATH_MAX] = { 0, };
-	if (batteryPercent > 87) {
-		data_get_resource_path("images/b100.png", imagePath, sizeof(imagePath));
-	} else if (batteryPercent > 62) {
-		data_get_resource_path("images/b75.png", imagePath, sizeof(imagePath));
-	} else if (batteryPercent > 37) {
-		data_get_resource_path("images/b50.png", imagePath, sizeof(imagePath));
-	} else if (batteryPercent > 12) {
-		data_get_resource_path("images/b25.png", imagePath, sizeof(imagePath));
-	} else {
-		data_get_resource_path("images/b0.png", imagePath, sizeof(imagePath));
+// Hands are decoded in place, a frame without them looks broken. The rest
+// show up once decoded in the background.
+static bool decodesAsync(Theme::Asset asset)
+{
+	switch (asset) {
+	case Theme::ASSET_HAND_HOUR:
+	case Theme::ASSET_HAND_HOUR_SHADOW:
+	case Theme::ASSET_HAND_MIN:
+	case Theme::ASSET_HAND_MIN_SHADOW:
+	case Theme::ASSET_HAND_SEC:
+	case Theme::ASSET_HAND_SEC_SHADOW:
+		return false;
+	default:
+		return true;
 	}
-	elm_image_file_set(batteryIcon_, imagePath, NULL);
+}
 
+bool Face::loadAsset(Theme::Asset asset)
+{
+	ThemedImage& image = themed_[asset];
+	if (!image.object) {
+		return false;
+	}
+	if (image.shown == image.wanted) {
+		return image.loaded;
+	}
+	assets_.Retain(image.wanted);
+	assets_.Release(image.shown);
+	image.shown = image.wanted;
+	image.loaded = image.wanted >= 0 && loadImage(image.object, assets_.File(image.wanted), decodesAsync(asset));
+#ifdef _DEBUG
+	int imageWidth = 0;
+	int imageHeight = 0;
+	Evas_Coord width = 0;
+	Evas_Coord height = 0;
+	evas_object_image_size_get(image.object, &imageWidth, &imageHeight);
+	evas_object_geometry_get(image.object, NULL, NULL, &width, &height);
+	if (image.loaded && display_.Native() && (imageWidth != width || imageHeight != height)) {
+		LOG_W("Image %s is %dx%d, scaled to %dx%d on every draw", assets_.File(image.shown), imageWidth, imageHeight, width, height);
+	}
+#endif
+	return image.loaded;
+}
 
-	char text[32] = { 0, };
-	snprintf(text, sizeof(text), "%d%%", batteryPercent);
-	elm_object_part_text_set(layout_, "txt.battery.num", text);
-	updateTextField("txt.steps.num", steps_ - lastSteps_);
+void Face::dropAsset(Theme::Asset asset)
+{
+	ThemedImage& image = themed_[asset];
+	if (image.shown < 0) {
+		return;
+	}
+	evas_object_image_file_set(image.object, NULL, NULL);
+	assets_.Release(image.shown);
+	image.shown = -1;
+	image.loaded = false;
 }
 
-void Face::updateTextField(const char* fieldId, int value)
+void Face::invalidateTexts()
 {
-	char text[32] = { 0, };
-	snprintf(text, sizeof(text), "%d", value);
-	elm_object_part_text_set(layout_, fieldId, text);
+	dateText_.Invalidate();
+	eventText_.Invalidate();
+	countdownText_.Invalidate();
+	weatherText_.Invalidate();
+	weatherTempText_.Invalidate();
+	batteryText_.Invalidate();
+	stepsText_.Invalidate();
+	moonText_.Invalidate();
 }
 
-void Face::setLastError(const char* fmt, ...)
+void Face::openTrace()
 {
-	char msg[64];
-	va_list args;
-	va_start(args, fmt);
-	vsprintf(msg, fmt, args);
-	va_end(args);
-	string s = msg;
-	errors_.push_back(s);
-	if (errors_.size() > 12) {
-		errors_.pop_front();
-	}
-	char allErrors[1024] = {0};
-	for (const auto& itr: errors_) {
-		strcat(allErrors, itr.c_str());
-		strcat(allErrors, "<br/>");
+	// The previous run's trace is kept, it may be the one that shows a crash
+	char path[PATH_MAX] = { 0, };
+	char prevPath[PATH_MAX] = { 0, };
+	data_get_data_path(TRACE_FILE, path, sizeof(path));
+	data_get_data_path(TRACE_PREV_FILE, prevPath, sizeof(prevPath));
+	rename(path, prevPath);
+	if (controller_.OpenTrace(path)) {
+		LOG_I("Recording inputs to %s", path);
 	}
-	elm_object_part_text_set(layout_, "txt.error", allErrors);
 }
 
-bool Face::LocationTimeoutCallback(void* data)
+void Face::rotateHand(Evas_Object *hand, double degree, Evas_Coord cx, Evas_Coord cy)
 {
-	Face* face = (Face*)data;
-	face->onLocationTimeout();
-	return false;
+	// The map is copied into the object, so one is enough for all hands
+	if (!handMap_) {
+		handMap_ = evas_map_new(4);
+	}
+	evas_map_util_points_populate_from_object(handMap_, hand);
+	evas_map_util_rotate(handMap_, degree, cx, cy);
+	evas_object_map_set(hand, handMap_);
+	evas_object_map_enable_set(hand, EINA_TRUE);
 }
 
-void Face::onLocationTimeout()
+bool Face::MoveHands(const HandAngles& angles)
 {
-	WATCH_ERR("%s", "l t/o");
-	locationStateRequested_ = locationState_ = 0;
-	requestLocationServiceState(LOCATIONS_SERVICE_DISABLED);
-	locationTimeoutTimer_ = NULL;
+	Evas_Coord centerX = display_.X(BASE_WIDTH / 2);
+	Evas_Coord centerY = display_.Y(BASE_HEIGHT / 2);
+	bool moved = false;
+
+	if (angles.hour != hourDegree_) {
+		hourDegree_ = angles.hour;
+		rotateHand(handHour_, angles.hour, centerX, centerY);
+		rotateHand(handHourShadow_, angles.hour, centerX, centerY + display_.Scale(theme_.GetHand(Theme::HAND_HOUR).shadowPadding));
+		moved = true;
+	}
+
+	if (angles.minute != minDegree_) {
+		minDegree_ = angles.minute;
+		rotateHand(handMin_, angles.minute, centerX, centerY);
+		rotateHand(handMinShadow_, angles.minute, centerX, centerY + display_.Scale(theme_.GetHand(Theme::HAND_MIN).shadowPadding));
+		moved = true;
+	}
+
+	if (angles.secondShown && angles.second != secDegree_) {
+		secDegree_ = angles.second;
+		rotateHand(handSec_, angles.second, centerX, centerY);
+		rotateHand(handsSecShadow_, angles.second,  centerX, centerY + display_.Scale(theme_.GetHand(Theme::HAND_SEC).shadowPadding));
+		moved = true;
+	}
+	return moved;
 }
 
-bool Face::requestLocationServiceState(location_service_state_e state)
+void Face::SetText(Text text, const char* value)
 {
-	int ret;
-	WATCH_ERR("Req: %d", state);
-	if (locationStateRequested_ != locationState_) {
-		dlog_print(DLOG_WARN, LOG_TAG, "%s Another request in progress", __FUNCTION__);
-		WATCH_ERR("%s", "err1");
-		return false;
-	}
-	if (state == LOCATIONS_SERVICE_ENABLED) {
-		ret = location_manager_start(locationManager_);
-		if (ret != LOCATIONS_ERROR_NONE) {
-			dlog_print(DLOG_ERROR, LOG_TAG, "location_manager_start failed: %s", get_error_message(ret));
-			WATCH_ERR("%s", "err2");
-			return false;
-		}
-		if (!locationTimeoutTimer_) {
-			locationTimeoutTimer_ = Timer::GetInstance().AddTimer(2 * 60, Face::LocationTimeoutCallback, this);
-			if (!locationTimeoutTimer_) {
-				WATCH_ERR("%s", "tmr fail");
-			}
-		}
-	} else if (state == LOCATIONS_SERVICE_DISABLED) {
-		ret = location_manager_stop(locationManager_);
-		if (ret != LOCATIONS_ERROR_NONE) {
-			dlog_print(DLOG_ERROR, LOG_TAG, "location_manager_stop failed: %s", get_error_message(ret));
-			WATCH_ERR("%s", "err3");
-			return false;
-		}
-	} else {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Unknown state: %d", state);
-		WATCH_ERR("%s", "err4");
-		return false;
+	TextPart* parts[] = {
+			&dateText_,
+			&moonText_,
+			&eventText_,
+			&countdownText_,
+			&weatherText_,
+			&weatherTempText_,
+			&batteryText_,
+			&stepsText_
+	};
+	static_assert(sizeof(parts) / sizeof(parts[0]) == TEXT_EVENTS, "Text parts don't match FaceView::Text");
+	if (text == TEXT_EVENTS) {
+		// Debug overlay, not worth a TextPart
+		elm_object_part_text_set(layout_, "txt.error", value);
+		return;
 	}
-	locationStateRequested_ = state;
-	return true;
+	parts[text]->Set(layout_, value);
+}
+
+void Face::SetIcon(Icon icon, const char* file)
+{
+	setImageFile(icon == ICON_WEATHER ? weatherIcon_ : batteryIcon_, file, true);
 }
@@ -0,0 +1,901 @@
+#include "FaceController.h"
+#include "CurlWrapper.h"
+#include "Log.h"
+#include "SolarCalc.h"
+#include "omahawatch.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sstream>
+#include <iomanip>
+
+static const char* Months[] = {
+		"Nul",
+		"Jan",
+		"Feb",
+		"Mar",
+		"Apr",
+		"May",
+		"Jun",
+		"Jul",
+		"Aug",
+		"Sep",
+		"Oct",
+		"Nov",
+		"Dec"
+};
+
+static const char* Weekdays[] = {
+		"Nul",
+		"Sun",
+		"Mon",
+		"Tue",
+		"Wed",
+		"Thu",
+		"Fri",
+		"Sat"
+};
+
+static time_t clockNow()
+{
+	return (time_t)Platform::Get().clock->Now();
+}
+
+static time_t localDayStart(time_t now)
+{
+	struct tm dayInfo;
+	localtime_r(&now, &dayInfo);
+	dayInfo.tm_hour = 0;
+	dayInfo.tm_min = 0;
+	dayInfo.tm_sec = 0;
+	dayInfo.tm_isdst = -1;
+	return mktime(&dayInfo);
+}
+
+FaceController::FaceController(FaceView* view):
+	view_(view),
+	weatherTimer_(),
+	weatherInterval_(0),
+	weatherStarted_(false),
+	refreshDeadline_(nullptr),
+	location_(Platform::Get().location),
+	locationMethod_(LocationScheduler::METHOD_WPS),
+	weatherUrl_(WEATHER_URL),
+	fetchStartTime_(0),
+	ambient_(false),
+	paused_(false),
+	quietBattery_(0),
+	batteryPercent_(0),
+	charging_(false),
+	online_(false),
+	weatherMissed_(false),
+	batteryIconLevel_(-1),
+	weatherIconFile_(),
+	lastTickDay_(-1),
+	longitude_(0),
+	latitude_(0),
+	hasLocation_(false),
+	eventsShown_(0),
+	tracedSteps_(-1),
+	batterySource_(-1),
+	stepLogSource_(-1),
+	quietSource_(-1),
+	stepsSource_(-1),
+	dateSource_(-1),
+	sunSource_(-1),
+	weatherSource_(-1),
+	eventsSource_(-1)
+{
+}
+
+FaceController::~FaceController()
+{
+	// Stops the location service and drops any weather result still on its
+	// way to the main loop
+	refresh_.Cancel();
+	events_.Log();
+	Platform::Get().battery->SetChangedCallback(nullptr, nullptr);
+	Platform::Get().connectivity->SetChangedCallback(nullptr, nullptr);
+	Platform::Get().clock->SetChangedCallback(nullptr, nullptr);
+	if (weatherTimer_) {
+		Timer::GetInstance().DeleteTimer(weatherTimer_);
+	}
+	destroyLocationManager();
+}
+
+bool FaceController::OpenTrace(const char* path)
+{
+	return trace_.Open(path);
+}
+
+void FaceController::Init()
+{
+	Stats::Take(stats_);
+	registerSources();
+
+	// Battery, network and time are followed through change events rather
+	// than read on every minute tick
+	readBattery();
+	updatePower();
+	online_ = Platform::Get().connectivity->Online();
+	trace_.Add(Trace::KIND_CONNECTIVITY, online_);
+	Platform::Get().battery->SetChangedCallback(FaceController::batteryChangedCallback, this);
+	Platform::Get().connectivity->SetChangedCallback(FaceController::connectivityChangedCallback, this);
+	Platform::Get().clock->SetChangedCallback(FaceController::timeChangedCallback, this);
+
+	// The view starts out with what the tier allows
+	updateSecondHand();
+	updateAnimatorState();
+}
+
+bool FaceController::SetupSensors(const char* stepLogPath)
+{
+	if (!stepLog_.Open(stepLogPath)) {
+		LOG_E("Failed to open step log %s. History is kept in memory", stepLogPath);
+		stepLog_.Open(NULL);
+	}
+	stepLog_.SetDay(localDayStart(clockNow()));
+
+	if (!sensorHub_.Subscribe(Sensors::KIND_PEDOMETER, SensorHub::AGGREGATE_LAST)) {
+		view_->SetText(FaceView::TEXT_STEPS, "--");
+		return false;
+	}
+	updateSensorPolicy();
+	return true;
+}
+
+bool FaceController::SetupLocation()
+{
+	static const RefreshPipeline::Definition location = { 2 * 60, FaceController::locationStartCallback, FaceController::locationStopCallback };
+	static const RefreshPipeline::Definition fetch = { 30, FaceController::fetchStartCallback, FaceController::fetchStopCallback };
+	refresh_.Init(&location, &fetch, FaceController::refreshDeadlineCallback, FaceController::refreshFinishedCallback, this);
+
+	bool opened = createLocationManager(LocationScheduler::METHOD_WPS);
+
+	// Sun markers only need a rough position, so start from the last fix
+	time_t timestamp;
+	if (location_->LastPosition(&latitude_, &longitude_, &timestamp)) {
+		hasLocation_ = true;
+		locationScheduler_.OnFix(timestamp, -1);
+		updateDayPlan(clockNow());
+	}
+
+	if (governor_.GetPolicy().locationEnabled) {
+		onWeatherTimer();
+	}
+
+	// Without a location manager the timer tries to open it again and the
+	// weather comes for the last position meanwhile
+	weatherStarted_ = true;
+	scheduleWeatherTimer();
+
+	return opened;
+}
+
+void FaceController::Tick(time_t now, int msec)
+{
+	trace_.Tick();
+	Timer::GetInstance().Tick();
+	struct tm timeInfo;
+	localtime_r(&now, &timeInfo);
+
+	if (timeInfo.tm_mday != lastTickDay_) {
+		lastTickDay_ = timeInfo.tm_mday;
+		stepLog_.SetDay(localDayStart(now));
+		sources_.Push(dateSource_);
+	}
+	if (sensorHub_.Drain() > 0 && !sensorHub_.NeedsRead(Sensors::KIND_PEDOMETER)) {
+		// Streamed steps are shown as they come in
+		sources_.Push(stepsSource_);
+	}
+	sensorHub_.Tick(now);
+	int locationOnSeconds = 0;
+	if (locationScheduler_.HourlyReport(now, &locationOnSeconds)) {
+		LOG_I("Location: on for %d s in the last hour", locationOnSeconds);
+		Stats::Snapshot stats;
+		Stats::Take(stats);
+		Stats::LogDelta(stats_, stats);
+		stats_ = stats;
+	}
+
+	moveHands(timeInfo, msec);
+	sources_.Tick(now);
+	traceSteps();
+}
+
+bool FaceController::Frame()
+{
+	// watch_time_get_current_time() allocates a handle, too much for every frame
+	double now = Platform::Get().clock->Now();
+	time_t seconds = (time_t)now;
+	struct tm timeInfo;
+	localtime_r(&seconds, &timeInfo);
+	bool moved = moveHands(timeInfo, (int)((now - seconds) * 1000));
+	Stats::Add(moved ? Stats::ANIMATOR_FRAMES_RENDERED : Stats::ANIMATOR_FRAMES_SKIPPED);
+	return moved;
+}
+
+void FaceController::Pause()
+{
+	// A running refresh carries on until its stage deadline. A fix rarely
+	// comes in within one glance, cancelling here would starve faces
+	// without always-on display.
+	paused_ = true;
+	trace_.Add(Trace::KIND_VISIBILITY, paused_, ambient_);
+	trace_.Flush();
+	updateAnimatorState();
+	updateSensorPolicy();
+}
+
+void FaceController::Resume()
+{
+	paused_ = false;
+	trace_.Add(Trace::KIND_VISIBILITY, paused_, ambient_);
+	updateAnimatorState();
+	updateSensorPolicy();
+}
+
+void FaceController::SetAmbient(bool ambient)
+{
+	ambient_ = ambient;
+	trace_.Add(Trace::KIND_VISIBILITY, paused_, ambient_);
+	updateSecondHand();
+	updateAnimatorState();
+	updateSensorPolicy();
+}
+
+void FaceController::LowBattery()
+{
+	if (governor_.LowBattery()) {
+		applyPowerPolicy();
+	}
+}
+
+void FaceController::SetQuietSchedule(const QuietMode::Schedule& schedule)
+{
+	quietMode_.SetSchedule(schedule);
+	// Entered or left right away rather than at the next minute
+	sources_.Push(quietSource_);
+}
+
+void FaceController::ToggleWeatherScale()
+{
+	weather_.ToggleScale();
+	sources_.Refresh(weatherSource_, clockNow());
+}
+
+void FaceController::traceSteps()
+{
+	// The counter as the face sees it, after the hub has folded the samples
+	int steps = stepCounter();
+	if (steps != tracedSteps_) {
+		tracedSteps_ = steps;
+		trace_.Add(Trace::KIND_SENSOR, Sensors::KIND_PEDOMETER, steps);
+	}
+}
+
+bool FaceController::createLocationManager(LocationScheduler::Method method)
+{
+	if (!location_->Open(method, FaceController::locationStateCallback, this)) {
+		return false;
+	}
+	locationMethod_ = method;
+	return true;
+}
+
+void FaceController::destroyLocationManager()
+{
+	if (!location_->IsOpen()) {
+		return;
+	}
+	location_->Close();
+	locationScheduler_.ServiceOff(clockNow());
+}
+
+int FaceController::stepCounter()
+{
+	if (!sensorHub_.HasData(Sensors::KIND_PEDOMETER)) {
+		return -1;
+	}
+	return (int)sensorHub_.Value(Sensors::KIND_PEDOMETER);
+}
+
+void FaceController::batteryChangedCallback(void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	if (controller->readBattery()) {
+		controller->updatePower();
+		controller->sources_.Push(controller->batterySource_);
+	}
+}
+
+bool FaceController::readBattery()
+{
+	int percent = batteryPercent_;
+	bool charging = charging_;
+	Platform::Get().battery->Percent(&percent);
+	Platform::Get().battery->Charging(&charging);
+	if (percent == batteryPercent_ && charging == charging_) {
+		return false;
+	}
+	batteryPercent_ = percent;
+	charging_ = charging;
+	events_.Add(EventRing::EVENT_BATTERY, percent, charging);
+	trace_.Add(Trace::KIND_BATTERY, percent, charging);
+	return true;
+}
+
+void FaceController::connectivityChangedCallback(void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	controller->onConnectivityChanged();
+}
+
+void FaceController::onConnectivityChanged()
+{
+	bool online = Platform::Get().connectivity->Online();
+	if (online == online_) {
+		return;
+	}
+	online_ = online;
+	events_.Add(EventRing::EVENT_CONNECTIVITY, online);
+	trace_.Add(Trace::KIND_CONNECTIVITY, online);
+	if (online) {
+		retryMissedRefresh();
+	}
+}
+
+void FaceController::timeChangedCallback(void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	controller->onTimeChanged();
+}
+
+void FaceController::onTimeChanged()
+{
+	events_.Add(EventRing::EVENT_TIME_CHANGED);
+	trace_.TimeChanged();
+	time_t now = clockNow();
+	// Timer deadlines are absolute, a clock set back would stall the weather timer
+	if (weatherTimer_) {
+		Timer::GetInstance().DeleteTimer(weatherTimer_);
+		weatherTimer_ = Timer::TimerHandle();
+		scheduleWeatherTimer();
+	}
+	// The next tick starts the step log day and the date again
+	lastTickDay_ = -1;
+	updateDayPlan(now);
+	sources_.InvalidateAll();
+}
+
+void FaceController::updatePower()
+{
+	if (governor_.Update(batteryPercent_, charging_)) {
+		applyPowerPolicy();
+	}
+}
+
+void FaceController::applyPowerPolicy()
+{
+	const char* tierName = PowerGovernor::TierName(governor_.GetTier());
+	LOG_I("Power tier: %s", tierName);
+	events_.Add(EventRing::EVENT_POWER_TIER, governor_.GetTier());
+
+	updateAnimatorState();
+	updateSecondHand();
+	updateSensorPolicy();
+	if (weatherStarted_) {
+		scheduleWeatherTimer();
+	}
+}
+
+void FaceController::updateQuiet(time_t now)
+{
+	if (quietMode_.Update(now, stepCounter())) {
+		applyQuietMode(now);
+	}
+	if (quietMode_.PreWakeDue(now)) {
+		LOG_I("Quiet: refreshing ahead of the wake time");
+		events_.Add(EventRing::EVENT_PRE_WAKE);
+		onWeatherTimer();
+	}
+}
+
+void FaceController::applyQuietMode(time_t now)
+{
+	bool quiet = quietMode_.Quiet();
+	events_.Add(EventRing::EVENT_QUIET, quiet);
+	if (quiet) {
+		LOG_I("Quiet mode on, battery %d%%", batteryPercent_);
+		quietBattery_ = batteryPercent_;
+		// A fix now would only be stale by the morning
+		if (refresh_.Current() == RefreshPipeline::STAGE_LOCATION) {
+			refresh_.Cancel();
+		}
+	} else {
+		LOG_I("Quiet mode off after %ld min, battery %d%% -> %d%%%s", (long)(now - quietMode_.QuietSince()) / 60,
+				quietBattery_, batteryPercent_, charging_ ? " charging" : "");
+	}
+	updateSensorPolicy();
+	if (weatherStarted_) {
+		scheduleWeatherTimer();
+	}
+	retryMissedRefresh();
+}
+
+void FaceController::updateAnimatorState()
+{
+	// In ambient and 1 Hz modes the hands are moved from Tick
+	view_->SetAnimating(!paused_ && !ambient_ && governor_.GetPolicy().secondHand == PowerGovernor::SECOND_HAND_SMOOTH);
+}
+
+void FaceController::updateSecondHand()
+{
+	view_->ShowSecondHand(!ambient_ && governor_.GetPolicy().secondHand != PowerGovernor::SECOND_HAND_OFF);
+}
+
+void FaceController::updateSensorPolicy()
+{
+	SensorPolicy::FaceState state = SensorPolicy::StateOf(paused_, ambient_);
+	sensorHub_.SetPolicy(Sensors::KIND_PEDOMETER, SensorPolicy::ForPedometer(state, governor_.GetPolicy().pedometerInterval, quietMode_.Quiet()));
+}
+
+void FaceController::scheduleWeatherTimer()
+{
+	int interval = quietMode_.Quiet() ? 0 : governor_.GetPolicy().weatherInterval;
+	if (weatherTimer_ && interval == weatherInterval_) {
+		return;
+	}
+	if (weatherTimer_) {
+		Timer::GetInstance().DeleteTimer(weatherTimer_);
+		weatherTimer_ = Timer::TimerHandle();
+	}
+	weatherInterval_ = interval;
+	if (interval > 0) {
+		weatherTimer_ = Timer::GetInstance().AddTimer(interval, weatherTimerFunc, this, "weather");
+	}
+}
+
+bool FaceController::moveHands(const struct tm& timeInfo, int msec)
+{
+	return view_->MoveHands(HandAngles::At(timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec, msec,
+			governor_.GetPolicy().secondHand, ambient_));
+}
+
+void FaceController::locationStateCallback(LocationSource::State state, void *data)
+{
+	FaceController* controller = (FaceController*)data;
+	controller->onLocationState(state);
+}
+
+void FaceController::onLocationState(LocationSource::State state)
+{
+	Stats::Add(Stats::LOCATION_CHANGES);
+	LOG_D("Location state change: %d", state);
+	events_.Add(EventRing::EVENT_LOCATION_STATE, state);
+	if (state != LocationSource::STATE_ENABLED || refresh_.Current() != RefreshPipeline::STAGE_LOCATION) {
+		return;
+	}
+	if (!updateLocation()) {
+		events_.Add(EventRing::EVENT_LOCATION_FAILED);
+		refresh_.Fail(RefreshPipeline::STAGE_LOCATION);
+		return;
+	}
+	refresh_.Complete(RefreshPipeline::STAGE_LOCATION);
+}
+
+void FaceController::registerSources()
+{
+	// Layout parts and objects each source redraws, nothing else touches them
+	static const DataSources::Definition battery = { "battery", 0, 0, { "txt.battery.num", "img.battery" } };
+	static const DataSources::Definition stepLog = { "step log", 60, 0, { } };
+	static const DataSources::Definition quiet = { "quiet", 60, 0, { } };
+	static const DataSources::Definition steps = { "steps", 0, 0, { "txt.steps.num" } };
+	static const DataSources::Definition date = { "date", 0, 0, { "txt.date", "txt.moon" } };
+	static const DataSources::Definition sun = { "sun", 60, 0, { "txt.date.event", "txt.date.countdown", "img.sun" } };
+	static const DataSources::Definition weather = { "weather", 0, 0, { "txt.weather", "txt.weather.temp", "img.weather" } };
+
+	batterySource_ = sources_.Register(&battery, sourceCallback<&FaceController::updateBattery>, this);
+	stepLogSource_ = sources_.Register(&stepLog, sourceCallback<&FaceController::updateStepLog>, this);
+	quietSource_ = sources_.Register(&quiet, sourceCallback<&FaceController::updateQuiet>, this);
+	stepsSource_ = sources_.Register(&steps, sourceCallback<&FaceController::updateSteps>, this);
+	dateSource_ = sources_.Register(&date, sourceCallback<&FaceController::updateDate>, this);
+	sunSource_ = sources_.Register(&sun, sourceCallback<&FaceController::updateSunEvent>, this);
+	weatherSource_ = sources_.Register(&weather, sourceCallback<&FaceController::updateWeatherText>, this);
+#ifdef _DEBUG
+	static const DataSources::Definition events = { "events", 60, 0, { "txt.error" } };
+	eventsSource_ = sources_.Register(&events, sourceCallback<&FaceController::updateEventOverlay>, this);
+#endif
+}
+
+void FaceController::updateBattery(time_t now)
+{
+	int batteryPercent = batteryPercent_;
+
+	static const char* batteryIcons[] = {
+			"images/b0.png",
+			"images/b25.png",
+			"images/b50.png",
+			"images/b75.png",
+			"images/b100.png"
+	};
+	int level = 0;
+	if (batteryPercent > 87) {
+		level = 4;
+	} else if (batteryPercent > 62) {
+		level = 3;
+	} else if (batteryPercent > 37) {
+		level = 2;
+	} else if (batteryPercent > 12) {
+		level = 1;
+	}
+	if (level != batteryIconLevel_) {
+		view_->SetIcon(FaceView::ICON_BATTERY, batteryIcons[level]);
+		batteryIconLevel_ = level;
+	}
+
+	char text[32] = { 0, };
+	snprintf(text, sizeof(text), "%d%%", batteryPercent);
+	view_->SetText(FaceView::TEXT_BATTERY, text);
+}
+
+void FaceController::updateStepLog(time_t now)
+{
+	if (!sensorHub_.Available(Sensors::KIND_PEDOMETER)) {
+		return;
+	}
+	if (sensorHub_.NeedsRead(Sensors::KIND_PEDOMETER)) {
+		sensorHub_.Read(Sensors::KIND_PEDOMETER);
+	}
+	if (!sensorHub_.HasData(Sensors::KIND_PEDOMETER)) {
+		return;
+	}
+	stepLog_.Append(now, (int)sensorHub_.Value(Sensors::KIND_PEDOMETER));
+	sources_.Push(stepsSource_);
+}
+
+void FaceController::updateSteps(time_t now)
+{
+	if (!sensorHub_.HasData(Sensors::KIND_PEDOMETER)) {
+		return;
+	}
+	int counter = (int)sensorHub_.Value(Sensors::KIND_PEDOMETER);
+	updateTextField(FaceView::TEXT_STEPS, stepLog_.TodaySteps() + stepLog_.Pending(counter));
+}
+
+void FaceController::updateDate(time_t now)
+{
+	struct tm timeInfo;
+	localtime_r(&now, &timeInfo);
+	char dateStr[32];
+	snprintf(dateStr, sizeof(dateStr), "%s %s %d", Weekdays[timeInfo.tm_wday + 1], Months[timeInfo.tm_mon + 1], timeInfo.tm_mday);
+	view_->SetText(FaceView::TEXT_DATE, dateStr);
+	view_->SetText(FaceView::TEXT_MOON, SolarCalc::MoonPhaseName(now));
+}
+
+void FaceController::updateSunEvent(time_t now)
+{
+	if (!dayPlan_.Ready()) {
+		// No position yet, or a polar day dropped the plan; don't leave a stale countdown
+		view_->SetText(FaceView::TEXT_EVENT, "");
+		view_->SetText(FaceView::TEXT_COUNTDOWN, "");
+		return;
+	}
+	if (dayPlan_.Advance(now)) {
+		// Recalculate for the new day rather than reuse yesterday's times
+		updateDayPlan(now);
+	}
+	bool sunrise = dayPlan_.Next().type == DayPlan::EVENT_SUNRISE;
+	int minutes = dayPlan_.MinutesUntilNext(now);
+
+	if (minutes == 0) {
+		view_->SetText(FaceView::TEXT_EVENT, sunrise ? "Sunrise is now" : "Sunset is now");
+		view_->SetText(FaceView::TEXT_COUNTDOWN, "");
+	} else {
+		char countdownStr[16];
+		snprintf(countdownStr, sizeof(countdownStr), "%.2d:%.2d", minutes / 60, minutes % 60);
+		view_->SetText(FaceView::TEXT_EVENT, sunrise ? "Sunrise in" : "Sunset in");
+		view_->SetText(FaceView::TEXT_COUNTDOWN, countdownStr);
+	}
+}
+
+void FaceController::updateWeatherText(time_t now)
+{
+	if (!weather_.Ready()) {
+		return;
+	}
+	char text[32] = { 0, };
+	weather_.GetDetails(text, sizeof(text));
+	view_->SetText(FaceView::TEXT_WEATHER, weather_.Location());
+	view_->SetText(FaceView::TEXT_WEATHER_TEMP, text);
+	if (strcmp(weatherIconFile_, weather_.Icon())) {
+		snprintf(weatherIconFile_, sizeof(weatherIconFile_), "%s", weather_.Icon());
+		view_->SetIcon(FaceView::ICON_WEATHER, weatherIconFile_);
+	}
+}
+
+void FaceController::updateEventOverlay(time_t now)
+{
+#ifdef _DEBUG
+	if (events_.Sequence() == eventsShown_) {
+		return;
+	}
+	eventsShown_ = events_.Sequence();
+	char text[1024];
+	events_.FormatLast(12, "<br/>", text, sizeof(text));
+	view_->SetText(FaceView::TEXT_EVENTS, text);
+#endif
+}
+
+void FaceController::updateTextField(FaceView::Text text, int value)
+{
+	char str[32] = { 0, };
+	snprintf(str, sizeof(str), "%d", value);
+	view_->SetText(text, str);
+}
+
+bool FaceController::weatherTimerFunc(void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	controller->onWeatherTimer();
+	return true;
+}
+
+void FaceController::onWeatherTimer()
+{
+	events_.Add(EventRing::EVENT_WEATHER_TIMER, refresh_.Current());
+
+	LOG_D("onWeatherTimer. Refresh stage: %s", RefreshPipeline::StageName(refresh_.Current()));
+	if (refresh_.Running()) {
+		if (!refreshDeadline_) {
+			// The deadline timer couldn't be added, this is the next best thing
+			refresh_.Expire();
+		}
+		return;
+	}
+	if (!online_) {
+		// No point in a location fix for a request that can't be sent
+		weatherMissed_ = true;
+		return;
+	}
+	// A location manager that failed to open is tried again
+	bool locationOn = governor_.GetPolicy().locationEnabled &&
+			(location_->IsOpen() || createLocationManager(locationScheduler_.GetMethod()));
+
+	// Another app may have got a newer fix meanwhile
+	double latitude, longitude;
+	time_t timestamp = 0;
+	if (location_->LastPosition(&latitude, &longitude, &timestamp) &&
+			timestamp > locationScheduler_.FixTime()) {
+		latitude_ = latitude;
+		longitude_ = longitude;
+		hasLocation_ = true;
+		locationScheduler_.OnFix(timestamp, -1);
+	}
+	if (!locationOn) {
+		if (hasLocation_) {
+			refresh_.Start(false);
+		}
+		return;
+	}
+	time_t now = clockNow();
+	bool locate = !hasLocation_ || locationScheduler_.NeedsFix(now, stepCounter());
+	if (!locate) {
+		LOG_D("Reusing location fix from %ld s ago", (long)(now - locationScheduler_.FixTime()));
+	}
+	refresh_.Start(locate);
+}
+
+void FaceController::retryMissedRefresh()
+{
+	if (!weatherMissed_ || !online_ || quietMode_.Quiet()) {
+		return;
+	}
+	weatherMissed_ = false;
+	onWeatherTimer();
+}
+
+bool FaceController::locationStartCallback(void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	return controller->startLocation();
+}
+
+void FaceController::locationStopCallback(bool completed, void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	controller->stopLocation();
+}
+
+bool FaceController::fetchStartCallback(void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	return controller->startFetch();
+}
+
+void FaceController::fetchStopCallback(bool completed, void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	if (!completed) {
+		controller->weatherToken_.Cancel();
+	}
+}
+
+void FaceController::refreshDeadlineCallback(int seconds, void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	MainLoop* mainLoop = Platform::Get().mainLoop;
+	if (controller->refreshDeadline_) {
+		mainLoop->DeleteTimeout(controller->refreshDeadline_);
+		controller->refreshDeadline_ = nullptr;
+	}
+	if (seconds > 0) {
+		// A main loop timer: Timer only runs from Tick, which stops while
+		// paused, and the location service must not stay on until the next resume
+		controller->refreshDeadline_ = mainLoop->AddTimeout(seconds, FaceController::refreshExpiredCallback, controller);
+		if (!controller->refreshDeadline_) {
+			controller->events_.Add(EventRing::EVENT_TIMER_FAILED);
+		}
+	}
+}
+
+void FaceController::refreshExpiredCallback(void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	Stats::Add(Stats::TIMER_CALLBACKS);
+	controller->refreshDeadline_ = nullptr;
+	controller->refresh_.Expire();
+}
+
+void FaceController::refreshFinishedCallback(RefreshPipeline::Stage stage, RefreshPipeline::Outcome outcome, void* data)
+{
+	FaceController* controller = (FaceController*)data;
+	controller->onRefreshFinished(stage, outcome);
+}
+
+bool FaceController::startLocation()
+{
+	if (locationMethod_ != locationScheduler_.GetMethod()) {
+		events_.Add(EventRing::EVENT_LOCATION_METHOD, locationScheduler_.GetMethod());
+		destroyLocationManager();
+		if (!createLocationManager(locationScheduler_.GetMethod())) {
+			return false;
+		}
+	}
+	if (!location_->Start()) {
+		events_.Add(EventRing::EVENT_LOCATION_START_FAILED);
+		return false;
+	}
+	trace_.Add(Trace::KIND_LOCATION_START, locationMethod_);
+	locationScheduler_.ServiceOn(clockNow());
+	return true;
+}
+
+void FaceController::stopLocation()
+{
+	trace_.Add(Trace::KIND_LOCATION_STOP);
+	if (!location_->Stop()) {
+		events_.Add(EventRing::EVENT_LOCATION_STOP_FAILED);
+	}
+	locationScheduler_.ServiceOff(clockNow());
+}
+
+#define Q(x)  #x
+#define QUOTE(x)  Q(x)
+
+struct FaceController::WeatherFetch
+{
+	WeatherInfo info;
+	bool parsed = false;
+	bool empty = true;
+	int err = 0;
+	size_t bytes = 0;
+};
+
+bool FaceController::startFetch()
+{
+	events_.Add(EventRing::EVENT_WEATHER_REQUEST);
+	if (!online_) {
+		// Retried when the connection comes back
+		weatherMissed_ = true;
+		return false;
+	}
+	std::stringstream weatherUrlSS;
+	weatherUrlSS << weatherUrl_ << "?lat=" << std::setprecision(3) << latitude_ << "&lon=" << longitude_ << "&APPID=" << QUOTE(WEATHER_TOKEN);
+	std::string url = weatherUrlSS.str();
+	// The connection handle isn't thread safe, the worker only gets the address
+	std::string proxy;
+	int proxyErr = Platform::Get().connectivity->Proxy(proxy);
+
+	// Fetch and parse on a worker, only the result is applied on the main loop.
+	// A stopped fetch cancels its token, the next one needs a fresh one.
+	weatherToken_ = CancelToken();
+	fetchStartTime_ = Platform::Get().clock->Monotonic();
+	WorkerPool::GetInstance().Submit<WeatherFetch>(weatherToken_,
+			[url, proxy, proxyErr](const CancelToken& cancel) {
+				WeatherFetch fetch;
+				if (proxyErr) {
+					fetch.err = CurlWrapper::errorProxy | proxyErr;
+					return fetch;
+				}
+				auto json = CurlWrapper::Get(url, fetch.err, &cancel, proxy);
+				fetch.empty = json.empty();
+				fetch.bytes = json.size();
+				if (!fetch.empty) {
+					fetch.parsed = fetch.info.FromJson(json.c_str());
+					LOG_V("Weather: %s", json.c_str());
+				}
+				return fetch;
+			},
+			[this](WeatherFetch& fetch) {
+				onWeatherFetched(fetch);
+			});
+	return true;
+}
+
+void FaceController::onWeatherFetched(const WeatherFetch& fetch)
+{
+	int latency = (int)((Platform::Get().clock->Monotonic() - fetchStartTime_) * 1000);
+	trace_.Add(Trace::KIND_HTTP, fetch.empty || fetch.parsed ? fetch.err : Trace::httpBadResponse, latency, fetch.bytes);
+	if (fetch.empty) {
+		events_.Add(EventRing::EVENT_CURL_FAILED, fetch.err);
+		refresh_.Fail(RefreshPipeline::STAGE_FETCH);
+		return;
+	}
+	if (fetch.err != 0) {
+		events_.Add(EventRing::EVENT_CURL_WARNING, fetch.err);
+	}
+	if (!fetch.parsed) {
+		events_.Add(EventRing::EVENT_JSON_ERROR);
+		refresh_.Fail(RefreshPipeline::STAGE_FETCH);
+		return;
+	}
+	weather_.Assign(fetch.info);
+	sources_.Refresh(weatherSource_, clockNow());
+	refresh_.Complete(RefreshPipeline::STAGE_FETCH);
+}
+
+void FaceController::onRefreshFinished(RefreshPipeline::Stage stage, RefreshPipeline::Outcome outcome)
+{
+	events_.Add(EventRing::EVENT_REFRESH, stage, outcome);
+	LOG_D("Refresh: %s %s", RefreshPipeline::StageName(stage), RefreshPipeline::OutcomeName(outcome));
+	if (stage == RefreshPipeline::STAGE_LOCATION && outcome == RefreshPipeline::OUTCOME_TIMEOUT) {
+		locationScheduler_.OnTimeout();
+	}
+	if (outcome == RefreshPipeline::OUTCOME_DONE) {
+		weatherMissed_ = false;
+	} else if (outcome == RefreshPipeline::OUTCOME_CANCELLED) {
+		weatherMissed_ = true;
+	}
+}
+
+bool FaceController::updateLocation()
+{
+	time_t timestamp;
+	if (!location_->Position(&latitude_, &longitude_, &timestamp)) {
+		return false;
+	}
+	trace_.Add(Trace::KIND_LOCATION_FIX, (int)(latitude_ * 1e6), (int)(longitude_ * 1e6));
+	hasLocation_ = true;
+	locationScheduler_.OnFix(timestamp, stepCounter());
+	updateDayPlan(clockNow());
+	return true;
+}
+
+void FaceController::updateDayPlan(time_t now)
+{
+	time_t sunrise = 0;
+	time_t sunset = 0;
+	if (!hasLocation_ || !SolarCalc::SunEvents(latitude_, longitude_, now, &sunrise, &sunset)) {
+		dayPlan_.Build(0, 0, now);
+		view_->PlaceSunIcons(dayPlan_);
+		sources_.Push(sunSource_);
+		return;
+	}
+	if (sunset / 60 < now / 60) {
+		SolarCalc::SunEvents(latitude_, longitude_, now + 24 * 60 * 60, &sunrise, &sunset);
+	}
+	dayPlan_.Build(sunrise, sunset, now);
+	view_->PlaceSunIcons(dayPlan_);
+	sources_.Push(sunSource_);
+}
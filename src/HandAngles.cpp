@@ -0,0 +1,15 @@
+#include "HandAngles.h"
+#include "omahawatch.h"
+
+HandAngles HandAngles::At(int hour, int minute, int second, int msec, PowerGovernor::SecondHand secondHand, bool ambient)
+{
+	HandAngles angles;
+	angles.hour = hour * HOUR_ANGLE + minute * HOUR_ANGLE / 60.0;
+	angles.minute = minute * MIN_ANGLE + second * MIN_ANGLE / 60.0;
+	angles.secondShown = !ambient && secondHand != PowerGovernor::SECOND_HAND_OFF;
+	angles.second = second * SEC_ANGLE;
+	if (secondHand == PowerGovernor::SECOND_HAND_SMOOTH) {
+		angles.second += msec * SEC_ANGLE / 1000.0;
+	}
+	return angles;
+}
@@ -0,0 +1,82 @@
+#include "LocationScheduler.h"
+
+// A stationary wearer still gets a fresh fix this often, steps don't
+// show travelling by car or train
+static constexpr time_t maxFixAge = 60 * 60;
+// Without step data only very recent fixes are reused
+static constexpr time_t maxBlindFixAge = 20 * 60;
+// Roughly 200 m of walking
+static constexpr int movementSteps = 300;
+static constexpr time_t secondsInHour = 60 * 60;
+
+LocationScheduler::LocationScheduler():
+	fixTime_(0),
+	fixCounter_(-1),
+	method_(METHOD_WPS),
+	onSince_(0),
+	hourStart_(0),
+	onSeconds_(0)
+{
+}
+
+void LocationScheduler::OnFix(time_t time, int stepCounter)
+{
+	fixTime_ = time;
+	fixCounter_ = stepCounter;
+	method_ = METHOD_WPS;
+}
+
+void LocationScheduler::OnTimeout()
+{
+	method_ = METHOD_HYBRID;
+}
+
+bool LocationScheduler::NeedsFix(time_t now, int stepCounter) const
+{
+	if (fixTime_ == 0) {
+		return true;
+	}
+	time_t age = now - fixTime_;
+	if (fixCounter_ < 0 || stepCounter < 0) {
+		return age >= maxBlindFixAge;
+	}
+	if (age >= maxFixAge) {
+		return true;
+	}
+	// The counter restarts with the device
+	int steps = stepCounter >= fixCounter_ ? stepCounter - fixCounter_ : stepCounter;
+	return steps >= movementSteps;
+}
+
+void LocationScheduler::ServiceOn(time_t now)
+{
+	if (onSince_ == 0) {
+		onSince_ = now;
+	}
+}
+
+void LocationScheduler::ServiceOff(time_t now)
+{
+	if (onSince_ != 0) {
+		onSeconds_ += now - (onSince_ > hourStart_ ? onSince_ : hourStart_);
+		onSince_ = 0;
+	}
+}
+
+bool LocationScheduler::HourlyReport(time_t now, int* onSeconds)
+{
+	if (hourStart_ == 0) {
+		hourStart_ = now;
+		return false;
+	}
+	if (now - hourStart_ < secondsInHour) {
+		return false;
+	}
+	*onSeconds = onSeconds_;
+	if (onSince_ != 0) {
+		*onSeconds += now - (onSince_ > hourStart_ ? onSince_ : hourStart_);
+	}
+	hourStart_ = now;
+	onSeconds_ = 0;
+	return true;
+}
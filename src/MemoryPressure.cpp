@@ -0,0 +1,66 @@
+#include "MemoryPressure.h"
+#include <malloc.h>
+#include "Diagnostics.h"
+#include "Log.h"
+
+static const char* TierNames[] = {
+		"none",
+		"caches",
+		"sprites",
+		"tables",
+		"network"
+};
+
+static_assert(sizeof(TierNames) / sizeof(TierNames[0]) == MemoryPressure::TIERS_NUM, "Tier name missing");
+
+MemoryPressure::MemoryPressure():
+	entries_(),
+	entriesNum_(0),
+	current_(TIER_NONE)
+{
+}
+
+bool MemoryPressure::Register(Tier tier, const char* name, Callback release, Callback restore, void* data)
+{
+	if (entriesNum_ == maxEntries) {
+		LOG_E("No free slot for memory releaser %s", name);
+		return false;
+	}
+	entries_[entriesNum_++] = { tier, name, release, restore, data };
+	return true;
+}
+
+void MemoryPressure::Raise(Tier tier)
+{
+	while (current_ < tier) {
+		current_ = (Tier)(current_ + 1);
+		int before = Diagnostics::ResidentKb();
+		for (int i = 0; i < entriesNum_; ++i) {
+			if (entries_[i].tier == current_) {
+				entries_[i].release(entries_[i].data);
+			}
+		}
+		// Hands what was freed back to the system rather than keeping it in the heap
+		malloc_trim(0);
+		LOG_I("Memory pressure: released %s, %d kB -> %d kB resident", TierName(current_), before, Diagnostics::ResidentKb());
+	}
+}
+
+void MemoryPressure::Relieve()
+{
+	if (current_ == TIER_NONE) {
+		return;
+	}
+	for (int i = 0; i < entriesNum_; ++i) {
+		if (entries_[i].tier <= current_ && entries_[i].restore) {
+			entries_[i].restore(entries_[i].data);
+		}
+	}
+	LOG_I("Memory pressure over after %s, %d kB resident", TierName(current_), Diagnostics::ResidentKb());
+	current_ = TIER_NONE;
+}
+
+const char* MemoryPressure::TierName(Tier tier)
+{
+	return TierNames[tier];
+}
@@ -0,0 +1,28 @@
+#include "Platform.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+static Platform CurrentPlatform = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+
+Platform& Platform::Get()
+{
+	return CurrentPlatform;
+}
+
+void Platform::Install(const Platform& platform)
+{
+	CurrentPlatform = platform;
+}
+
+void platform_log(Logger::Level level, const char* fmt, ...)
+{
+	if (!CurrentPlatform.logger) {
+		return;
+	}
+	char msg[512];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(msg, sizeof(msg), fmt, args);
+	va_end(args);
+	CurrentPlatform.logger->Write(level, msg);
+}
@@ -0,0 +1,84 @@
+#include "PowerGovernor.h"
+
+static constexpr int saverEnter = 30;
+static constexpr int saverLeave = 35;
+static constexpr int criticalEnter = 15;
+static constexpr int criticalLeave = 20;
+
+static const PowerGovernor::Policy Policies[] = {
+		/* TIER_FULL */     { PowerGovernor::SECOND_HAND_SMOOTH, 10 * 60, true, 1000 },
+		/* TIER_SAVER */    { PowerGovernor::SECOND_HAND_TICK, 60 * 60, true, 0 },
+		/* TIER_CRITICAL */ { PowerGovernor::SECOND_HAND_OFF, 0, false, 0 }
+};
+
+static const char* TierNames[] = {
+		"full",
+		"saver",
+		"critical"
+};
+
+PowerGovernor::PowerGovernor():
+	tier_(TIER_FULL),
+	lowBattery_(false)
+{
+}
+
+bool PowerGovernor::Update(int batteryPercent, bool charging)
+{
+	Tier prev = tier_;
+	if (charging) {
+		lowBattery_ = false;
+		tier_ = TIER_FULL;
+		return tier_ != prev;
+	}
+	if (lowBattery_ && batteryPercent >= criticalLeave) {
+		lowBattery_ = false;
+	}
+	if (lowBattery_) {
+		tier_ = TIER_CRITICAL;
+		return tier_ != prev;
+	}
+
+	switch (tier_) {
+	case TIER_FULL:
+		if (batteryPercent <= criticalEnter) {
+			tier_ = TIER_CRITICAL;
+		} else if (batteryPercent <= saverEnter) {
+			tier_ = TIER_SAVER;
+		}
+		break;
+	case TIER_SAVER:
+		if (batteryPercent <= criticalEnter) {
+			tier_ = TIER_CRITICAL;
+		} else if (batteryPercent >= saverLeave) {
+			tier_ = TIER_FULL;
+		}
+		break;
+	case TIER_CRITICAL:
+		if (batteryPercent >= saverLeave) {
+			tier_ = TIER_FULL;
+		} else if (batteryPercent >= criticalLeave) {
+			tier_ = TIER_SAVER;
+		}
+		break;
+	}
+	return tier_ != prev;
+}
+
+bool PowerGovernor::LowBattery()
+{
+	Tier prev = tier_;
+	lowBattery_ = true;
+	tier_ = TIER_CRITICAL;
+	return tier_ != prev;
+}
+
+const PowerGovernor::Policy& PowerGovernor::GetPolicy() const
+{
+	return Policies[tier_];
+}
+
+const char* PowerGovernor::TierName(Tier tier)
+{
+	return TierNames[tier];
+}
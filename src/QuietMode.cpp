@@ -0,0 +1,166 @@
+#include "QuietMode.h"
+#include <stdio.h>
+#include <string.h>
+
+// Steps within one inactivity period that count as being up and about
+static constexpr int activeSteps = 20;
+
+QuietMode::Schedule QuietMode::DefaultSchedule()
+{
+	return { 23 * 60, 7 * 60, 30, 15 };
+}
+
+static bool validMinutes(int minutes)
+{
+	return minutes >= 0 && minutes < 24 * 60;
+}
+
+QuietMode::Schedule QuietMode::NoSchedule()
+{
+	Schedule schedule = DefaultSchedule();
+	schedule.start = 0;
+	schedule.end = 0;
+	return schedule;
+}
+
+bool QuietMode::ParseSchedule(const char* text, Schedule* schedule)
+{
+	if (!strcmp(text, "off")) {
+		*schedule = NoSchedule();
+		return true;
+	}
+	Schedule parsed = DefaultSchedule();
+	int startHour, startMinute, endHour, endMinute;
+	int fields = sscanf(text, "%d:%d-%d:%d %d %d", &startHour, &startMinute, &endHour, &endMinute,
+			&parsed.inactivity, &parsed.preWake);
+	if (fields < 4) {
+		return false;
+	}
+	if (startMinute < 0 || startMinute > 59 || endMinute < 0 || endMinute > 59) {
+		return false;
+	}
+	parsed.start = startHour * 60 + startMinute;
+	parsed.end = endHour * 60 + endMinute;
+	if (!validMinutes(parsed.start) || !validMinutes(parsed.end) || parsed.start == parsed.end) {
+		return false;
+	}
+	if (!validMinutes(parsed.inactivity) || !validMinutes(parsed.preWake)) {
+		return false;
+	}
+	*schedule = parsed;
+	return true;
+}
+
+void QuietMode::FormatSchedule(const Schedule& schedule, char* out, size_t len)
+{
+	if (schedule.start == schedule.end) {
+		snprintf(out, len, "off");
+		return;
+	}
+	snprintf(out, len, "%.2d:%.2d-%.2d:%.2d %d %d", schedule.start / 60, schedule.start % 60,
+			schedule.end / 60, schedule.end % 60, schedule.inactivity, schedule.preWake);
+}
+
+QuietMode::QuietMode():
+	schedule_(DefaultSchedule()),
+	quiet_(false),
+	quietSince_(0),
+	windowEnd_(0),
+	preWakeDone_(0),
+	lastActive_(0),
+	periodStart_(0),
+	periodCounter_(0)
+{
+}
+
+void QuietMode::SetSchedule(const Schedule& schedule)
+{
+	schedule_ = schedule;
+}
+
+bool QuietMode::Update(time_t now, int stepCounter)
+{
+	if (lastActive_ == 0) {
+		// Whoever just started the face is awake
+		lastActive_ = now;
+	}
+	noteSteps(now, stepCounter);
+	bool quiet = inWindow(now) && now - lastActive_ >= schedule_.inactivity * 60;
+	if (quiet == quiet_) {
+		return false;
+	}
+	quiet_ = quiet;
+	if (quiet) {
+		quietSince_ = now;
+		time_t end = windowEnd(now);
+		if (end != windowEnd_) {
+			windowEnd_ = end;
+			// Gone quiet right before the end, the data is fresh anyway
+			if (now >= windowEnd_ - schedule_.preWake * 60) {
+				preWakeDone_ = windowEnd_;
+			}
+		}
+	}
+	return true;
+}
+
+bool QuietMode::PreWakeDue(time_t now)
+{
+	if (!quiet_ || schedule_.preWake <= 0 || preWakeDone_ == windowEnd_) {
+		return false;
+	}
+	if (now < windowEnd_ - schedule_.preWake * 60) {
+		return false;
+	}
+	preWakeDone_ = windowEnd_;
+	return true;
+}
+
+bool QuietMode::inWindow(time_t now) const
+{
+	struct tm timeInfo;
+	localtime_r(&now, &timeInfo);
+	int minute = timeInfo.tm_hour * 60 + timeInfo.tm_min;
+	if (schedule_.start == schedule_.end) {
+		return false;
+	}
+	if (schedule_.start < schedule_.end) {
+		return minute >= schedule_.start && minute < schedule_.end;
+	}
+	return minute >= schedule_.start || minute < schedule_.end;
+}
+
+time_t QuietMode::windowEnd(time_t now) const
+{
+	struct tm endInfo;
+	localtime_r(&now, &endInfo);
+	endInfo.tm_hour = schedule_.end / 60;
+	endInfo.tm_min = schedule_.end % 60;
+	endInfo.tm_sec = 0;
+	endInfo.tm_isdst = -1;
+	time_t end = mktime(&endInfo);
+	if (end <= now) {
+		endInfo.tm_mday += 1;
+		endInfo.tm_hour = schedule_.end / 60;
+		endInfo.tm_min = schedule_.end % 60;
+		endInfo.tm_isdst = -1;
+		end = mktime(&endInfo);
+	}
+	return end;
+}
+
+void QuietMode::noteSteps(time_t now, int stepCounter)
+{
+	if (stepCounter < 0) {
+		return;
+	}
+	if (periodStart_ != 0 && stepCounter - periodCounter_ >= activeSteps) {
+		lastActive_ = now;
+	}
+	// The counter goes back to 0 on reboot
+	if (periodStart_ == 0 || stepCounter < periodCounter_ || lastActive_ == now ||
+			now - periodStart_ >= schedule_.inactivity * 60) {
+		periodStart_ = now;
+		periodCounter_ = stepCounter;
+	}
+}
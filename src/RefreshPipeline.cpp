@@ -0,0 +1,123 @@
+#include "RefreshPipeline.h"
+
+static const char* StageNames[] = {
+		"idle",
+		"location",
+		"fetch"
+};
+
+static_assert(sizeof(StageNames) / sizeof(StageNames[0]) == RefreshPipeline::STAGES_NUM, "Stage name missing");
+
+static const char* OutcomeNames[] = {
+		"done",
+		"failed",
+		"timeout",
+		"cancelled"
+};
+
+static_assert(sizeof(OutcomeNames) / sizeof(OutcomeNames[0]) == RefreshPipeline::OUTCOMES_NUM, "Outcome name missing");
+
+RefreshPipeline::RefreshPipeline():
+	stages_(),
+	deadline_(nullptr),
+	finished_(nullptr),
+	data_(nullptr),
+	current_(STAGE_IDLE)
+{
+}
+
+void RefreshPipeline::Init(const Definition* location, const Definition* fetch,
+		DeadlineCallback deadline, FinishedCallback finished, void* data)
+{
+	stages_[STAGE_LOCATION] = location;
+	stages_[STAGE_FETCH] = fetch;
+	deadline_ = deadline;
+	finished_ = finished;
+	data_ = data;
+}
+
+bool RefreshPipeline::Start(bool locate)
+{
+	if (Running()) {
+		return false;
+	}
+	enter(locate ? STAGE_LOCATION : STAGE_FETCH);
+	return true;
+}
+
+void RefreshPipeline::Complete(Stage stage)
+{
+	if (stage != current_ || stage == STAGE_IDLE) {
+		return;
+	}
+	leave(true);
+	if (stage == STAGE_LOCATION) {
+		enter(STAGE_FETCH);
+	} else {
+		finish(stage, OUTCOME_DONE);
+	}
+}
+
+void RefreshPipeline::Fail(Stage stage)
+{
+	if (stage != current_ || stage == STAGE_IDLE) {
+		return;
+	}
+	leave(false);
+	finish(stage, OUTCOME_FAILED);
+}
+
+void RefreshPipeline::Expire()
+{
+	Stage stage = current_;
+	if (stage == STAGE_IDLE) {
+		return;
+	}
+	leave(false);
+	finish(stage, OUTCOME_TIMEOUT);
+}
+
+void RefreshPipeline::Cancel()
+{
+	Stage stage = current_;
+	if (stage == STAGE_IDLE) {
+		return;
+	}
+	leave(false);
+	finish(stage, OUTCOME_CANCELLED);
+}
+
+const char* RefreshPipeline::StageName(Stage stage)
+{
+	return StageNames[stage];
+}
+
+const char* RefreshPipeline::OutcomeName(Outcome outcome)
+{
+	return OutcomeNames[outcome];
+}
+
+void RefreshPipeline::enter(Stage stage)
+{
+	current_ = stage;
+	deadline_(stages_[stage]->deadline, data_);
+	// The work may already be done when start returns, current_ has moved on then
+	if (!stages_[stage]->start(data_)) {
+		finish(stage, OUTCOME_FAILED);
+	}
+}
+
+void RefreshPipeline::leave(bool completed)
+{
+	const Definition* stage = stages_[current_];
+	// Reports from the stop callback are for a stage that is over
+	current_ = STAGE_IDLE;
+	stage->stop(completed, data_);
+}
+
+void RefreshPipeline::finish(Stage stage, Outcome outcome)
+{
+	current_ = STAGE_IDLE;
+	deadline_(0, data_);
+	finished_(stage, outcome, data_);
+}
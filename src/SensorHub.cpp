@@ -0,0 +1,211 @@
+#include "SensorHub.h"
+#include "Log.h"
+#include "Stats.h"
+
+static constexpr int secondsInHour = 60 * 60;
+
+SensorHub::SensorHub():
+	channelsNum_(0),
+	dropped_(0),
+	hourStart_(0)
+{
+}
+
+SensorHub::~SensorHub()
+{
+	for (int i = 0; i < channelsNum_; ++i) {
+		Channel& channel = channels_[i];
+		delete channel.device;
+	}
+}
+
+bool SensorHub::Subscribe(Sensors::Kind kind, Aggregation aggregation)
+{
+	if (channelsNum_ == maxChannels) {
+		LOG_E("Too many sensors");
+		return false;
+	}
+	if (findChannel(kind)) {
+		return true;
+	}
+
+	SensorDevice* device = Platform::Get().sensors->Open(kind);
+	if (!device) {
+		return false;
+	}
+
+	Channel& channel = channels_[channelsNum_];
+	channel.hub = this;
+	channel.kind = kind;
+	channel.device = device;
+	channel.aggregation = aggregation;
+	// Running without callbacks until a policy is set
+	channel.policy = { SensorPolicy::DELIVERY_ON_DEMAND, 0, 0 };
+	channel.started = true;
+	channel.hasData = false;
+	channel.value = 0;
+	channel.count = 0;
+	channel.sum = 0;
+	channel.max = 0;
+	channel.wakeups = 0;
+	channel.reads = 0;
+	++channelsNum_;
+	return true;
+}
+
+void SensorHub::SetPolicy(Sensors::Kind kind, const SensorPolicy::Policy& policy)
+{
+	Channel* channel = findChannel(kind);
+	if (!channel) {
+		return;
+	}
+	// A sensor that failed to start is tried again with the same policy
+	bool settled = channel->started || channel->policy.delivery == SensorPolicy::DELIVERY_PAUSED;
+	if (settled && policy.delivery == channel->policy.delivery && policy.interval == channel->policy.interval &&
+			policy.batchLatency == channel->policy.batchLatency) {
+		return;
+	}
+	channel->policy = policy;
+
+	channel->device->SetCallback(0, 0, nullptr, nullptr);
+	if (policy.delivery == SensorPolicy::DELIVERY_PAUSED) {
+		if (channel->started) {
+			channel->device->Stop();
+			channel->started = false;
+		}
+		return;
+	}
+
+	if (policy.delivery == SensorPolicy::DELIVERY_STREAM || policy.delivery == SensorPolicy::DELIVERY_BATCHED) {
+		channel->device->SetCallback(policy.interval, policy.batchLatency, SensorHub::eventCallback, channel);
+	}
+	if (!channel->started) {
+		if (!channel->device->Start()) {
+			return;
+		}
+		channel->started = true;
+	}
+}
+
+bool SensorHub::Read(Sensors::Kind kind)
+{
+	Channel* channel = findChannel(kind);
+	if (!channel || !channel->started) {
+		return false;
+	}
+	float value;
+	if (!channel->device->Read(&value)) {
+		return false;
+	}
+	++channel->reads;
+	channel->value = value;
+	channel->hasData = true;
+	return true;
+}
+
+bool SensorHub::NeedsRead(Sensors::Kind kind) const
+{
+	const Channel* channel = findChannel(kind);
+	return !channel || channel->policy.delivery != SensorPolicy::DELIVERY_STREAM;
+}
+
+bool SensorHub::HasData(Sensors::Kind kind) const
+{
+	const Channel* channel = findChannel(kind);
+	return channel && channel->hasData;
+}
+
+float SensorHub::Value(Sensors::Kind kind) const
+{
+	const Channel* channel = findChannel(kind);
+	return channel ? channel->value : 0;
+}
+
+int SensorHub::Drain()
+{
+	int drained = 0;
+	for (int i = 0; i < channelsNum_; ++i) {
+		Channel& channel = channels_[i];
+		float value;
+		while (channel.queue.Pop(value)) {
+			++drained;
+			if (channel.count == 0 || value > channel.max) {
+				channel.max = value;
+			}
+			channel.sum += value;
+			++channel.count;
+			if (channel.aggregation == AGGREGATE_LAST) {
+				channel.value = value;
+			}
+		}
+		if (channel.count == 0) {
+			continue;
+		}
+		if (channel.aggregation == AGGREGATE_MEAN) {
+			channel.value = channel.sum / channel.count;
+		} else if (channel.aggregation == AGGREGATE_MAX) {
+			channel.value = channel.max;
+		}
+		channel.hasData = true;
+		channel.count = 0;
+		channel.sum = 0;
+	}
+	return drained;
+}
+
+void SensorHub::Tick(time_t now)
+{
+	if (hourStart_ == 0) {
+		hourStart_ = now;
+		return;
+	}
+	if (now - hourStart_ < secondsInHour) {
+		return;
+	}
+	for (int i = 0; i < channelsNum_; ++i) {
+		Channel& channel = channels_[i];
+		LOG_I("Sensor %d: %d wakeups, %d reads in the last hour",
+				channel.kind, channel.wakeups.exchange(0), channel.reads);
+		channel.reads = 0;
+	}
+	int dropped = dropped_.exchange(0);
+	if (dropped) {
+		LOG_W("Sensor queue dropped %d samples in the last hour", dropped);
+	}
+	hourStart_ = now;
+}
+
+void SensorHub::eventCallback(float value, void* data)
+{
+	Channel* channel = (Channel*)data;
+	channel->hub->onEvent(channel, value);
+}
+
+void SensorHub::onEvent(Channel* channel, float value)
+{
+	channel->wakeups.fetch_add(1, std::memory_order_relaxed);
+	Stats::Add(Stats::SENSOR_CALLBACKS);
+	if (!channel->queue.Push(value)) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+SensorHub::Channel* SensorHub::findChannel(Sensors::Kind kind)
+{
+	for (int i = 0; i < channelsNum_; ++i) {
+		if (channels_[i].kind == kind) {
+			return &channels_[i];
+		}
+	}
+	return nullptr;
+}
+
+const SensorHub::Channel* SensorHub::findChannel(Sensors::Kind kind) const
+{
+	for (int i = 0; i < channelsNum_; ++i) {
+		if (channels_[i].kind == kind) {
+			return &channels_[i];
+		}
+	}
+	return nullptr;
+}
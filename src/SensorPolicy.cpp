@@ -0,0 +1,35 @@
+#include "SensorPolicy.h"
+
+static constexpr int ambientInterval = 60 * 1000;
+static constexpr int ambientBatchLatency = 5 * 60 * 1000;
+// The longest batch the hub queue takes with room left for other sensors
+static constexpr int quietInterval = 5 * 60 * 1000;
+static constexpr int quietBatchLatency = 60 * 60 * 1000;
+
+SensorPolicy::FaceState SensorPolicy::StateOf(bool paused, bool ambient)
+{
+	if (paused) {
+		return FACE_HIDDEN;
+	}
+	return ambient ? FACE_AMBIENT : FACE_INTERACTIVE;
+}
+
+SensorPolicy::Policy SensorPolicy::ForPedometer(FaceState state, int tierInterval, bool quiet)
+{
+	if (state == FACE_HIDDEN) {
+		return { DELIVERY_PAUSED, 0, 0 };
+	}
+	if (tierInterval <= 0) {
+		return { DELIVERY_ON_DEMAND, 0, 0 };
+	}
+	if (state == FACE_AMBIENT && quiet) {
+		// The minute tick reads the counter anyway, callbacks only wake the CPU
+		return { DELIVERY_BATCHED, quietInterval, quietBatchLatency };
+	}
+	if (state == FACE_AMBIENT) {
+		// Ambient only redraws once a minute, finer samples would only
+		// overflow the hub queue when the batch is flushed
+		return { DELIVERY_BATCHED, ambientInterval, ambientBatchLatency };
+	}
+	return { DELIVERY_STREAM, tierInterval, 0 };
+}
@@ -0,0 +1,178 @@
+#include "SolarCalc.h"
+#include <math.h>
+
+static constexpr double unixEpochJd = 2440587.5;
+static constexpr long secondsInDay = 24 * 60 * 60;
+static constexpr double j2000Jd = 2451545.0;
+static constexpr double synodicMonth = 29.530588853;
+// First new moon of 2000, 2000-01-06 18:14 UTC
+static constexpr double newMoonJd = 2451550.1;
+// Apparent sunrise: refraction and the solar disc radius
+static constexpr double sunriseZenith = 90.833;
+
+static const char* MoonPhases[] = {
+		"New moon",
+		"Waxing crescent",
+		"First quarter",
+		"Waxing gibbous",
+		"Full moon",
+		"Waning gibbous",
+		"Last quarter",
+		"Waning crescent"
+};
+
+static inline double degToRad(double deg)
+{
+	return deg * M_PI / 180.0;
+}
+
+static inline double radToDeg(double rad)
+{
+	return rad * 180.0 / M_PI;
+}
+
+static inline double julianCentury(double jd)
+{
+	return (jd - j2000Jd) / 36525.0;
+}
+
+static double geomMeanLongSun(double t)
+{
+	double l0 = fmod(280.46646 + t * (36000.76983 + t * 0.0003032), 360.0);
+	return l0 < 0 ? l0 + 360.0 : l0;
+}
+
+static double geomMeanAnomalySun(double t)
+{
+	return 357.52911 + t * (35999.05029 - 0.0001537 * t);
+}
+
+static double eccentricityEarthOrbit(double t)
+{
+	return 0.016708634 - t * (0.000042037 + 0.0000001267 * t);
+}
+
+static double sunEqOfCenter(double t)
+{
+	double m = degToRad(geomMeanAnomalySun(t));
+	return sin(m) * (1.914602 - t * (0.004817 + 0.000014 * t)) +
+			sin(2 * m) * (0.019993 - 0.000101 * t) +
+			sin(3 * m) * 0.000289;
+}
+
+static double sunApparentLong(double t)
+{
+	double trueLong = geomMeanLongSun(t) + sunEqOfCenter(t);
+	double omega = 125.04 - 1934.136 * t;
+	return trueLong - 0.00569 - 0.00478 * sin(degToRad(omega));
+}
+
+static double obliquityCorrection(double t)
+{
+	double seconds = 21.448 - t * (46.8150 + t * (0.00059 - t * 0.001813));
+	double e0 = 23.0 + (26.0 + seconds / 60.0) / 60.0;
+	double omega = 125.04 - 1934.136 * t;
+	return e0 + 0.00256 * cos(degToRad(omega));
+}
+
+static double sunDeclination(double t)
+{
+	double e = degToRad(obliquityCorrection(t));
+	double lambda = degToRad(sunApparentLong(t));
+	return radToDeg(asin(sin(e) * sin(lambda)));
+}
+
+// Minutes
+static double equationOfTime(double t)
+{
+	double epsilon = degToRad(obliquityCorrection(t));
+	double l0 = degToRad(geomMeanLongSun(t));
+	double e = eccentricityEarthOrbit(t);
+	double m = degToRad(geomMeanAnomalySun(t));
+	double y = tan(epsilon / 2.0);
+	y *= y;
+	double eqTime = y * sin(2.0 * l0) - 2.0 * e * sin(m) + 4.0 * e * y * sin(m) * cos(2.0 * l0) -
+			0.5 * y * y * sin(4.0 * l0) - 1.25 * e * e * sin(2.0 * m);
+	return radToDeg(eqTime) * 4.0;
+}
+
+static bool hourAngleSunrise(double latitude, double declination, double* hourAngle)
+{
+	double latRad = degToRad(latitude);
+	double decRad = degToRad(declination);
+	double arg = cos(degToRad(sunriseZenith)) / (cos(latRad) * cos(decRad)) - tan(latRad) * tan(decRad);
+	if (arg < -1.0 || arg > 1.0) {
+		return false;
+	}
+	*hourAngle = radToDeg(acos(arg));
+	return true;
+}
+
+// Event time in minutes from 00:00 UTC of the day starting at julian day `jd`
+static bool sunEventUtc(bool rise, double jd, double latitude, double longitude, double* minutes)
+{
+	double utc = 720.0;
+	// Second pass refines the sun position for the time of the event itself
+	for (int i = 0; i < 2; ++i) {
+		double t = julianCentury(jd + utc / 1440.0);
+		double hourAngle = 0;
+		if (!hourAngleSunrise(latitude, sunDeclination(t), &hourAngle)) {
+			return false;
+		}
+		if (!rise) {
+			hourAngle = -hourAngle;
+		}
+		utc = 720.0 - 4.0 * (longitude + hourAngle) - equationOfTime(t);
+	}
+	*minutes = utc;
+	return true;
+}
+
+bool SolarCalc::SunEvents(double latitude, double longitude, time_t day, time_t* sunrise, time_t* sunset)
+{
+	struct tm noonInfo;
+	localtime_r(&day, &noonInfo);
+	noonInfo.tm_hour = 12;
+	noonInfo.tm_min = 0;
+	noonInfo.tm_sec = 0;
+	noonInfo.tm_isdst = -1;
+	time_t localNoon = mktime(&noonInfo);
+
+	// The events are computed around the solar noon of a UTC day. Take the
+	// UTC day whose solar noon is nearest to the local one: where the zone
+	// is far from the longitude's own (Kiritimati, +14 at 157 W) the local
+	// date's UTC day has its solar noon in the next or previous local day.
+	double solarNoonMinutes = 720.0 - 4.0 * longitude;
+	long utcDay = lround((localNoon - solarNoonMinutes * 60.0) / secondsInDay);
+	time_t midnightUtc = utcDay * secondsInDay;
+	double jd = unixEpochJd + utcDay;
+
+	double riseMinutes = 0;
+	double setMinutes = 0;
+	if (!sunEventUtc(true, jd, latitude, longitude, &riseMinutes) ||
+			!sunEventUtc(false, jd, latitude, longitude, &setMinutes)) {
+		return false;
+	}
+	*sunrise = midnightUtc + (time_t)lround(riseMinutes * 60.0);
+	*sunset = midnightUtc + (time_t)lround(setMinutes * 60.0);
+	return true;
+}
+
+double SolarCalc::MoonAge(time_t time)
+{
+	double jd = unixEpochJd + time / 86400.0;
+	double age = fmod((jd - newMoonJd) / synodicMonth, 1.0);
+	return age < 0 ? age + 1.0 : age;
+}
+
+double SolarCalc::MoonIllumination(time_t time)
+{
+	return (1.0 - cos(2.0 * M_PI * MoonAge(time))) / 2.0;
+}
+
+const char* SolarCalc::MoonPhaseName(time_t time)
+{
+	int phasesNum = sizeof(MoonPhases) / sizeof(MoonPhases[0]);
+	int phase = (int)floor(MoonAge(time) * phasesNum + 0.5) % phasesNum;
+	return MoonPhases[phase];
+}
@@ -0,0 +1,80 @@
+#include "Stats.h"
+#include <stdio.h>
+#include <string.h>
+#include "Log.h"
+
+static const char* CounterNames[] = {
+		"frames rendered",
+		"frames skipped",
+		"time ticks",
+		"ambient ticks",
+		"timer callbacks",
+		"location changes",
+		"image loads",
+		"text sets",
+		"source refreshes",
+		"sensor callbacks",
+		"http requests"
+};
+
+static_assert(sizeof(CounterNames) / sizeof(CounterNames[0]) == Stats::COUNTERS_NUM, "Counter name missing");
+
+Stats::Line Stats::mainLine_;
+Stats::Line Stats::threadLine_;
+Stats::TimerStat Stats::timers_[maxTimers];
+int Stats::timersNum_ = 0;
+
+static int findTimer(const Stats::TimerStat* timers, int num, const char* name)
+{
+	for (int i = 0; i < num; ++i) {
+		if (timers[i].name == name || !strcmp(timers[i].name, name)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void Stats::AddTimerCallback(const char* name, int interval)
+{
+	int i = findTimer(timers_, timersNum_, name);
+	if (i < 0) {
+		if (timersNum_ == maxTimers) {
+			// Still in TIMER_CALLBACKS
+			return;
+		}
+		i = timersNum_++;
+		timers_[i] = { name, interval, 0 };
+	}
+	timers_[i].interval = interval;
+	++timers_[i].callbacks;
+}
+
+void Stats::Take(Snapshot& snapshot)
+{
+	for (int i = 0; i < COUNTERS_NUM; ++i) {
+		snapshot.values[i] = slot((Counter)i).load(std::memory_order_relaxed);
+	}
+	memcpy(snapshot.timers, timers_, sizeof(timers_));
+	snapshot.timersNum = timersNum_;
+}
+
+const char* Stats::Name(Counter counter)
+{
+	return CounterNames[counter];
+}
+
+void Stats::LogDelta(const Snapshot& from, const Snapshot& to)
+{
+	char line[256];
+	int len = 0;
+	for (int i = 0; i < COUNTERS_NUM && len < (int)sizeof(line); ++i) {
+		len += snprintf(line + len, sizeof(line) - len, "%s%s %u", i ? ", " : "", CounterNames[i], to.values[i] - from.values[i]);
+	}
+	LOG_I("Stats: %s", line);
+	for (int i = 0; i < to.timersNum; ++i) {
+		const TimerStat& timer = to.timers[i];
+		int before = findTimer(from.timers, from.timersNum, timer.name);
+		uint32_t callbacks = timer.callbacks - (before < 0 ? 0 : from.timers[before].callbacks);
+		LOG_I("Stats: timer %s (%d s) %u callbacks", timer.name, timer.interval, callbacks);
+	}
+}
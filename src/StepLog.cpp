@@ -0,0 +1,243 @@
+#include "StepLog.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr uint32_t stepLogMagic = 0x534c4f47; // "SLOG"
+static constexpr uint32_t stepLogVersion = 2;
+
+StepLog::StepLog():
+	fd_(-1),
+	header_(nullptr),
+	records_(nullptr),
+	dayStart_(0),
+	todaySteps_(0)
+{
+	memset(hourSteps_, 0, sizeof(hourSteps_));
+}
+
+StepLog::~StepLog()
+{
+	Close();
+}
+
+bool StepLog::Open(const char* path)
+{
+	Close();
+	size_t size = sizeof(Header) + capacity * sizeof(Record);
+	int flags = MAP_SHARED;
+	if (path) {
+		fd_ = open(path, O_RDWR | O_CREAT, 0600);
+		if (fd_ < 0) {
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd_, &st) != 0 || (st.st_size != (off_t)size && ftruncate(fd_, size) != 0)) {
+			Close();
+			return false;
+		}
+	} else {
+		flags |= MAP_ANONYMOUS;
+	}
+	void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd_, 0);
+	if (map == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	header_ = static_cast<Header*>(map);
+	records_ = reinterpret_cast<Record*>(header_ + 1);
+
+	if (header_->magic != stepLogMagic || header_->version != stepLogVersion ||
+			header_->capacity != capacity) {
+		reset();
+	} else {
+		recover();
+	}
+	return true;
+}
+
+void StepLog::Close()
+{
+	if (header_) {
+		munmap(header_, sizeof(Header) + capacity * sizeof(Record));
+		header_ = nullptr;
+		records_ = nullptr;
+	}
+	if (fd_ >= 0) {
+		close(fd_);
+		fd_ = -1;
+	}
+}
+
+bool StepLog::Trim()
+{
+	if (!header_ || fd_ < 0) {
+		return false;
+	}
+	// Dirty pages stay in the page cache, nothing is lost
+	return madvise(header_, sizeof(Header) + capacity * sizeof(Record), MADV_DONTNEED) == 0;
+}
+
+uint32_t StepLog::headerCheck(const Header* header)
+{
+	return (header->magic ^ header->version ^ header->capacity ^ (header->head * 2654435761u) ^ header->count) + 1;
+}
+
+uint16_t StepLog::recordCheck(const Record* record)
+{
+	uint32_t check = record->minute * 2654435761u ^ record->sequence * 40503u ^
+			(uint32_t)record->counter ^ ((uint32_t)record->steps << 16);
+	return (uint16_t)((check >> 16) ^ check ^ 0x5a5a);
+}
+
+bool StepLog::recordValid(const Record* record)
+{
+	return record->minute != 0 && record->check == recordCheck(record);
+}
+
+void StepLog::reset()
+{
+	memset(records_, 0, capacity * sizeof(Record));
+	header_->capacity = capacity;
+	header_->head = 0;
+	header_->count = 0;
+	header_->version = stepLogVersion;
+	header_->check = headerCheck(header_);
+	// Magic goes last so a half written header is never taken for valid
+	header_->magic = stepLogMagic;
+}
+
+void StepLog::recover()
+{
+	if (header_->check != headerCheck(header_) || header_->head >= capacity || header_->count > capacity) {
+		// Rebuild the position from the newest valid record
+		uint32_t newest = capacity;
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < capacity; ++i) {
+			if (!recordValid(&records_[i])) {
+				continue;
+			}
+			++count;
+			if (newest == capacity || records_[i].sequence > records_[newest].sequence) {
+				newest = i;
+			}
+		}
+		header_->head = newest == capacity ? 0 : (newest + 1) % capacity;
+		header_->count = count;
+	}
+	// Records appended after the last header update. Minutes go back with
+	// the clock, the sequence tells them from the ring's previous lap.
+	for (uint32_t i = 0; i < capacity; ++i) {
+		const Record* prev = last();
+		const Record* next = &records_[header_->head];
+		if (!recordValid(next) || (prev && next->sequence != prev->sequence + 1)) {
+			break;
+		}
+		header_->head = (header_->head + 1) % capacity;
+		if (header_->count < capacity) {
+			++header_->count;
+		}
+	}
+	// A torn record at the head of the log
+	while (header_->count > 0 && !recordValid(last())) {
+		header_->head = (header_->head + capacity - 1) % capacity;
+		--header_->count;
+	}
+	header_->check = headerCheck(header_);
+}
+
+const StepLog::Record* StepLog::last() const
+{
+	if (!header_ || header_->count == 0) {
+		return nullptr;
+	}
+	return &records_[(header_->head + capacity - 1) % capacity];
+}
+
+void StepLog::SetDay(time_t dayStart)
+{
+	dayStart_ = dayStart;
+	todaySteps_ = 0;
+	memset(hourSteps_, 0, sizeof(hourSteps_));
+	if (!header_) {
+		return;
+	}
+	uint32_t dayStartMinute = dayStart / 60;
+	// Records from before a baseline at or past its minute were stamped by
+	// a clock that was ahead
+	uint32_t limit = UINT32_MAX;
+	const Record* newer = nullptr;
+	for (uint32_t i = 1; i <= header_->count; ++i) {
+		const Record* record = &records_[(header_->head + capacity - i) % capacity];
+		if (newer && record->minute >= newer->minute && newer->minute < limit) {
+			limit = newer->minute;
+		}
+		newer = record;
+		if (record->minute >= limit) {
+			continue;
+		}
+		if (record->minute < dayStartMinute) {
+			break;
+		}
+		addToDay(record);
+	}
+}
+
+void StepLog::addToDay(const Record* record)
+{
+	int hour = (int)(((time_t)record->minute * 60 - dayStart_) / (60 * 60));
+	// 25 hour DST days fold the extra hour into the last one. Later
+	// minutes were stamped by a clock that was ahead.
+	if (hour < 0 || hour > 24) {
+		return;
+	}
+	if (hour > 23) {
+		hour = 23;
+	}
+	todaySteps_ += record->steps;
+	hourSteps_[hour] += record->steps;
+}
+
+int StepLog::Pending(int counter) const
+{
+	const Record* prev = last();
+	if (!prev) {
+		return 0;
+	}
+	// The sensor counter restarts with the device
+	return counter >= prev->counter ? counter - prev->counter : counter;
+}
+
+void StepLog::Append(time_t now, int counter)
+{
+	if (!header_) {
+		return;
+	}
+	uint32_t minute = now / 60;
+	const Record* prev = last();
+	if (prev && minute == prev->minute) {
+		return;
+	}
+
+	Record record;
+	record.minute = minute;
+	record.sequence = prev ? prev->sequence + 1 : 1;
+	record.counter = counter;
+	// A clock set back starts a new baseline
+	int steps = prev && minute > prev->minute ? Pending(counter) : 0;
+	record.steps = steps > UINT16_MAX ? UINT16_MAX : steps;
+	record.check = recordCheck(&record);
+
+	records_[header_->head] = record;
+	header_->head = (header_->head + 1) % capacity;
+	if (header_->count < capacity) {
+		++header_->count;
+	}
+	header_->check = headerCheck(header_);
+
+	if (now >= dayStart_) {
+		addToDay(&record);
+	}
+}
@@ -0,0 +1,22 @@
+#include "TextPart.h"
+#include "Stats.h"
+#include <string.h>
+
+TextPart::TextPart(const char* name):
+	name_(name),
+	valid_(false)
+{
+	text_[0] = '\0';
+}
+
+void TextPart::Set(Evas_Object* layout, const char* text)
+{
+	if (valid_ && !strcmp(text_, text)) {
+		return;
+	}
+	strncpy(text_, text, sizeof(text_) - 1);
+	text_[sizeof(text_) - 1] = '\0';
+	valid_ = strlen(text) < sizeof(text_);
+	Stats::Add(Stats::TEXT_SETS);
+	elm_object_part_text_set(layout, name_, text);
+}
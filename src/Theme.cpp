@@ -0,0 +1,216 @@
+#include "Theme.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Log.h"
+
+// Manifests are a few lines, anything bigger isn't one
+static constexpr int maxManifest = 4096;
+
+static const char* AssetNames[] = {
+		"bg",
+		"bg.ambient",
+		"hand.hour",
+		"hand.hour.shadow",
+		"hand.min",
+		"hand.min.shadow",
+		"hand.sec",
+		"hand.sec.shadow",
+		"sunrise",
+		"sunset"
+};
+
+static_assert(sizeof(AssetNames) / sizeof(AssetNames[0]) == Theme::ASSETS_NUM, "Asset name missing");
+
+static const char* HandNames[] = {
+		"hour",
+		"min",
+		"sec"
+};
+
+static_assert(sizeof(HandNames) / sizeof(HandNames[0]) == Theme::HANDS_NUM, "Hand name missing");
+
+// The look the face shipped with before theme packs
+static const char* BuiltinFiles[] = {
+		"images/chrono_clock_bg.png",
+		"images/chrono_clock_bg_black.png",
+		"images/chrono_hand_hour.png",
+		"images/chrono_hand_hour_shadow.png",
+		"images/chrono_hand_min.png",
+		"images/chrono_hand_min_shadow.png",
+		"images/chrono_hand_sec.png",
+		"images/chrono_hand_sec_shadow.png",
+		"images/sunrise.png",
+		"images/sunset.png"
+};
+
+static_assert(sizeof(BuiltinFiles) / sizeof(BuiltinFiles[0]) == Theme::ASSETS_NUM, "Built-in asset missing");
+
+static const Theme::HandGeometry BuiltinHands[] = {
+		{ 28, 360, 6 },
+		{ 28, 360, 6 },
+		{ 28, 360, 3 }
+};
+
+static bool copyString(char* out, size_t len, const char* value)
+{
+	size_t valueLen = strlen(value);
+	if (valueLen >= len) {
+		return false;
+	}
+	memcpy(out, value, valueLen + 1);
+	return true;
+}
+
+static bool parseSize(const char* value, int* out)
+{
+	if (!value) {
+		return false;
+	}
+	char* end = nullptr;
+	long size = strtol(value, &end, 10);
+	if (*end != '\0' || size <= 0 || size > 10000) {
+		return false;
+	}
+	*out = (int)size;
+	return true;
+}
+
+Theme::Theme():
+	sunIconSize_(20)
+{
+	copyString(name_, sizeof(name_), "chrono");
+	copyString(layout_, sizeof(layout_), "edje/main.edj");
+	copyString(group_, sizeof(group_), "omaha");
+	for (int i = 0; i < ASSETS_NUM; ++i) {
+		copyString(files_[i], sizeof(files_[i]), BuiltinFiles[i]);
+	}
+	for (int i = 0; i < HANDS_NUM; ++i) {
+		hands_[i] = BuiltinHands[i];
+	}
+}
+
+bool Theme::Parse(const char* text)
+{
+	char line[256];
+	int lineNum = 0;
+	while (*text) {
+		size_t len = strcspn(text, "\n");
+		++lineNum;
+		if (len >= sizeof(line)) {
+			LOG_E("Theme line %d too long", lineNum);
+			return false;
+		}
+		memcpy(line, text, len);
+		line[len] = '\0';
+		text += len;
+		if (*text == '\n') {
+			++text;
+		}
+		if (!parseLine(line)) {
+			LOG_E("Theme line %d can't be parsed", lineNum);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Theme::Load(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	if (!file) {
+		return false;
+	}
+	char text[maxManifest];
+	size_t len = fread(text, 1, sizeof(text) - 1, file);
+	bool whole = feof(file);
+	fclose(file);
+	if (!whole) {
+		LOG_E("Theme manifest %s too big", path);
+		return false;
+	}
+	text[len] = '\0';
+	return Parse(text);
+}
+
+bool Theme::InPack(const char* file)
+{
+	return strncmp(file, "./", 2) == 0;
+}
+
+const char* Theme::AssetName(Asset asset)
+{
+	return AssetNames[asset];
+}
+
+const char* Theme::HandName(Hand hand)
+{
+	return HandNames[hand];
+}
+
+bool Theme::parseLine(char* line)
+{
+	char* hash = strchr(line, '#');
+	if (hash) {
+		*hash = '\0';
+	}
+	const char* separators = " \t\r";
+	char* save = nullptr;
+	const char* key = strtok_r(line, separators, &save);
+	if (!key) {
+		return true;
+	}
+	const char* args[4] = { };
+	int argsNum = 0;
+	const char* arg;
+	while ((arg = strtok_r(nullptr, separators, &save))) {
+		if (argsNum == 4) {
+			return false;
+		}
+		args[argsNum++] = arg;
+	}
+
+	if (!strcmp(key, "name")) {
+		return argsNum == 1 && copyString(name_, sizeof(name_), args[0]);
+	}
+	if (!strcmp(key, "layout")) {
+		return argsNum == 2 && copyString(layout_, sizeof(layout_), args[0]) &&
+				copyString(group_, sizeof(group_), args[1]);
+	}
+	if (!strcmp(key, "image")) {
+		if (argsNum != 2) {
+			return false;
+		}
+		for (int i = 0; i < ASSETS_NUM; ++i) {
+			if (!strcmp(args[0], AssetNames[i])) {
+				return copyString(files_[i], sizeof(files_[i]), args[1]);
+			}
+		}
+		LOG_W("Unknown theme asset %s", args[0]);
+		return true;
+	}
+	if (!strcmp(key, "hand")) {
+		if (argsNum != 4) {
+			return false;
+		}
+		for (int i = 0; i < HANDS_NUM; ++i) {
+			if (!strcmp(args[0], HandNames[i])) {
+				HandGeometry hand;
+				if (!parseSize(args[1], &hand.width) || !parseSize(args[2], &hand.height)) {
+					return false;
+				}
+				// A shadow right under the hand is fine
+				hand.shadowPadding = atoi(args[3]);
+				hands_[i] = hand;
+				return true;
+			}
+		}
+		return false;
+	}
+	if (!strcmp(key, "sun")) {
+		return argsNum == 1 && parseSize(args[0], &sunIconSize_);
+	}
+	// A newer pack on an older face
+	LOG_W("Unknown theme key %s", key);
+	return true;
+}
@@ -1,4 +1,6 @@
 #include "Timer.h"
+#include "Platform.h"
+#include "Log.h"
 
 Timer& Timer::GetInstance()
 {
@@ -7,75 +9,87 @@ Timer& Timer::GetInstance()
 }
 
 Timer::Timer():
-	lastTimestamp_((int)ecore_time_unix_get())
+	events_(),
+	lastId_(0),
+	lastTimestamp_((int)Platform::Get().clock->Now())
 {
 
 }
 
 Timer::~Timer()
 {
-	for (auto itr: events_) {
-		delete itr;
-	}
+
 }
 
 
-Timer::TimerHandle Timer::AddTimer(int seconds, TimerCallback cb, void* data)
+Timer::TimerHandle Timer::AddTimer(int seconds, TimerCallback cb, void* data, const char* name/* = "unnamed"*/)
 {
 	advanceTime();
-	Event* event = new Event();
-	event->cb = cb;
-	event->time = lastTimestamp_ + seconds;
-	event->interval = seconds;
-	event->data = data;
-	addEvent(event);
-	return event;
+	for (int slot = 0; slot < capacity; ++slot) {
+		Event& event = events_[slot];
+		if (event.id) {
+			continue;
+		}
+		if (++lastId_ == 0) {
+			++lastId_;
+		}
+		event.id = lastId_;
+		event.cb = cb;
+		event.time = lastTimestamp_ + seconds;
+		event.interval = seconds;
+		event.data = data;
+		event.name = name;
+		return TimerHandle(slot, event.id);
+	}
+	LOG_E("No free slot for timer %s", name);
+	return TimerHandle();
 }
 
 void Timer::DeleteTimer(Timer::TimerHandle handle)
 {
 	advanceTime();
-	for (auto itr = events_.begin(); itr != events_.end(); ++itr) {
-		if (*itr == handle) {
-			itr = events_.erase(itr);
-			delete handle;
-			break;
-		}
+	if (!handle || handle.slot < 0 || handle.slot >= capacity) {
+		return;
+	}
+	Event& event = events_[handle.slot];
+	if (event.id == handle.id) {
+		event.id = 0;
 	}
 }
 
 void Timer::Tick()
 {
 	advanceTime();
-	while (events_.size() > 0 && events_.front()->time <= lastTimestamp_) {
-		Event* event = events_.front();
-		events_.pop_front();
+	Event* event;
+	while ((event = nextDue())) {
+		// The callback may delete its own timer and reuse the slot
+		uint32_t id = event->id;
+		Stats::Add(Stats::TIMER_CALLBACKS);
+		Stats::AddTimerCallback(event->name, event->interval);
 		bool recur = event->cb(event->data);
+		if (event->id != id) {
+			continue;
+		}
 		if (recur) {
 			event->time = lastTimestamp_ + event->interval;
-			addEvent(event);
 		} else {
-			delete event;
+			event->id = 0;
 		}
 	}
 }
 
 void Timer::advanceTime()
 {
-	lastTimestamp_ = (int)ecore_time_unix_get();
+	lastTimestamp_ = (int)Platform::Get().clock->Now();
 }
 
-void Timer::addEvent(Event* event)
+Timer::Event* Timer::nextDue()
 {
-	bool found = false;
-	for (auto itr = events_.begin(); itr != events_.end(); ++itr) {
-		if ((*itr)->time > event->time) {
-			events_.insert(itr, event);
-			found = true;
-			break;
+	Event* next = nullptr;
+	for (auto& event: events_) {
+		if (event.id && event.time <= lastTimestamp_ && (!next || event.time < next->time)) {
+			next = &event;
 		}
 	}
-	if (!found) {
-		events_.push_back(event);
-	}
+	return next;
 }
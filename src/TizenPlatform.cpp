@@ -0,0 +1,490 @@
+#include "TizenPlatform.h"
+#include "Platform.h"
+#include <Elementary.h>
+#include <dlog.h>
+#include <tizen.h>
+#include <sensor.h>
+#include <locations.h>
+#include <device/battery.h>
+#include <device/callback.h>
+#include <net_connection.h>
+#include <system_settings.h>
+#include <stdlib.h>
+#include <time.h>
+#include "omahawatch.h"
+#include "Log.h"
+
+class TizenClock: public Clock
+{
+public:
+	TizenClock():
+		cb_(nullptr),
+		data_(nullptr)
+	{
+	}
+
+	~TizenClock()
+	{
+		SetChangedCallback(nullptr, nullptr);
+	}
+
+	double Now() override { return ecore_time_unix_get(); }
+	double Monotonic() override
+	{
+		// ecore_time_get() stops while the watch is suspended
+		struct timespec ts;
+		clock_gettime(CLOCK_BOOTTIME, &ts);
+		return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+
+	void SetChangedCallback(ChangedCallback cb, void* data) override
+	{
+		static const system_settings_key_e keys[] = { SYSTEM_SETTINGS_KEY_TIME_CHANGED, SYSTEM_SETTINGS_KEY_LOCALE_TIMEZONE };
+		bool subscribed = cb_ != nullptr;
+		cb_ = cb;
+		data_ = data;
+		if (subscribed == (cb != nullptr)) {
+			return;
+		}
+		for (auto key: keys) {
+			int ret = cb ? system_settings_set_changed_cb(key, settingsCallback, this) : system_settings_unset_changed_cb(key);
+			if (ret != SYSTEM_SETTINGS_ERROR_NONE) {
+				LOG_E("system_settings changed cb %d failed: %s", key, get_error_message(ret));
+			}
+		}
+	}
+private:
+	static void settingsCallback(system_settings_key_e key, void* data)
+	{
+		TizenClock* clock = (TizenClock*)data;
+		// localtime_r keeps the zone it loaded first
+		tzset();
+		if (clock->cb_) {
+			clock->cb_(clock->data_);
+		}
+	}
+
+	ChangedCallback cb_;
+	void* data_;
+};
+
+class TizenLogger: public Logger
+{
+public:
+	void Write(Level level, const char* msg) override
+	{
+		static const log_priority priorities[] = { DLOG_VERBOSE, DLOG_DEBUG, DLOG_INFO, DLOG_WARN, DLOG_ERROR };
+		dlog_print(priorities[level], LOG_TAG, "%s", msg);
+	}
+};
+
+class TizenSensorDevice: public SensorDevice
+{
+public:
+	TizenSensorDevice(sensor_type_e type, sensor_listener_h listener):
+		type_(type),
+		listener_(listener),
+		cb_(nullptr),
+		data_(nullptr)
+	{
+	}
+
+	~TizenSensorDevice()
+	{
+		sensor_listener_unset_event_cb(listener_);
+		sensor_listener_stop(listener_);
+		sensor_destroy_listener(listener_);
+	}
+
+	bool Start() override
+	{
+		int ret = sensor_listener_start(listener_);
+		if (ret != SENSOR_ERROR_NONE) {
+			LOG_E("sensor_listener_start(%d) failed: %s", type_, get_error_message(ret));
+			return false;
+		}
+		return true;
+	}
+
+	void Stop() override
+	{
+		sensor_listener_stop(listener_);
+	}
+
+	void SetCallback(int interval, int batchLatency, EventCallback cb, void* data) override
+	{
+		sensor_listener_unset_event_cb(listener_);
+		cb_ = cb;
+		data_ = data;
+		if (!cb) {
+			return;
+		}
+		sensor_listener_set_max_batch_latency(listener_, batchLatency);
+		sensor_listener_set_event_cb(listener_, interval, TizenSensorDevice::eventCallback, this);
+	}
+
+	bool Read(float* value) override
+	{
+		sensor_event_s event;
+		if (sensor_listener_read_data(listener_, &event) != SENSOR_ERROR_NONE) {
+			return false;
+		}
+		*value = event.values[0];
+		return true;
+	}
+private:
+	static void eventCallback(sensor_h sensorHanlder, sensor_event_s* event, void* data)
+	{
+		TizenSensorDevice* device = (TizenSensorDevice*)data;
+		device->cb_(event->values[0], device->data_);
+	}
+
+	sensor_type_e type_;
+	sensor_listener_h listener_;
+	EventCallback cb_;
+	void* data_;
+};
+
+class TizenSensors: public Sensors
+{
+public:
+	SensorDevice* Open(Kind kind) override
+	{
+		static const sensor_type_e types[] = { SENSOR_HUMAN_PEDOMETER, SENSOR_HRM, SENSOR_PRESSURE };
+		sensor_type_e type = types[kind];
+		sensor_h sensorHanlder;
+		int ret = sensor_get_default_sensor(type, &sensorHanlder);
+		if (ret != SENSOR_ERROR_NONE) {
+			LOG_E("sensor_get_default_sensor(%d) failed: %s", type, get_error_message(ret));
+			return nullptr;
+		}
+		sensor_listener_h listener;
+		ret = sensor_create_listener(sensorHanlder, &listener);
+		if (ret != SENSOR_ERROR_NONE) {
+			LOG_E("sensor_create_listener(%d) failed: %s", type, get_error_message(ret));
+			return nullptr;
+		}
+		// Keeps counting and sampling with the display off
+		sensor_listener_set_option(listener, SENSOR_OPTION_ALWAYS_ON);
+		TizenSensorDevice* device = new TizenSensorDevice(type, listener);
+		if (!device->Start()) {
+			delete device;
+			return nullptr;
+		}
+		return device;
+	}
+};
+
+class TizenLocation: public LocationSource
+{
+public:
+	TizenLocation():
+		manager_(NULL),
+		cb_(nullptr),
+		data_(nullptr)
+	{
+	}
+
+	~TizenLocation()
+	{
+		Close();
+	}
+
+	bool Open(LocationScheduler::Method method, StateCallback cb, void* data) override
+	{
+		int ret = location_manager_create(method == LocationScheduler::METHOD_WPS ? LOCATIONS_METHOD_WPS : LOCATIONS_METHOD_HYBRID, &manager_);
+		if (ret == LOCATIONS_ERROR_NOT_SUPPORTED && method == LocationScheduler::METHOD_WPS) {
+			LOG_W("WPS is not supported, using hybrid");
+			ret = location_manager_create(LOCATIONS_METHOD_HYBRID, &manager_);
+		}
+		if (ret != LOCATIONS_ERROR_NONE) {
+			LOG_E("location_manager_create failed: %s", get_error_message(ret));
+			manager_ = NULL;
+			return false;
+		}
+		ret = location_manager_set_service_state_changed_cb(manager_, TizenLocation::stateCallback, this);
+		if (ret != LOCATIONS_ERROR_NONE) {
+			LOG_E("location_manager_set_service_state_changed_cb failed: %s", get_error_message(ret));
+			location_manager_destroy(manager_);
+			manager_ = NULL;
+			return false;
+		}
+		cb_ = cb;
+		data_ = data;
+		return true;
+	}
+
+	void Close() override
+	{
+		if (!manager_) {
+			return;
+		}
+		location_manager_unset_service_state_changed_cb(manager_);
+		location_manager_stop(manager_);
+		location_manager_destroy(manager_);
+		manager_ = NULL;
+	}
+
+	bool IsOpen() override { return manager_ != NULL; }
+
+	bool Start() override
+	{
+		int ret = location_manager_start(manager_);
+		if (ret != LOCATIONS_ERROR_NONE) {
+			LOG_E("location_manager_start failed: %s", get_error_message(ret));
+			return false;
+		}
+		return true;
+	}
+
+	bool Stop() override
+	{
+		int ret = location_manager_stop(manager_);
+		if (ret != LOCATIONS_ERROR_NONE) {
+			LOG_E("location_manager_stop failed: %s", get_error_message(ret));
+			return false;
+		}
+		return true;
+	}
+
+	bool Position(double* latitude, double* longitude, time_t* timestamp) override
+	{
+		double altitude;
+		int ret = location_manager_get_position(manager_, &altitude, latitude, longitude, timestamp);
+		if (ret != LOCATIONS_ERROR_NONE) {
+			LOG_E("location_manager_get_position failed: %s", get_error_message(ret));
+			return false;
+		}
+		return true;
+	}
+
+	bool LastPosition(double* latitude, double* longitude, time_t* timestamp) override
+	{
+		if (!manager_) {
+			return false;
+		}
+		double altitude;
+		return location_manager_get_last_position(manager_, &altitude, latitude, longitude, timestamp) == LOCATIONS_ERROR_NONE;
+	}
+private:
+	static void stateCallback(location_service_state_e state, void* data)
+	{
+		TizenLocation* location = (TizenLocation*)data;
+		location->cb_(state == LOCATIONS_SERVICE_ENABLED ? STATE_ENABLED : STATE_DISABLED, location->data_);
+	}
+
+	location_manager_h manager_;
+	StateCallback cb_;
+	void* data_;
+};
+
+class TizenBattery: public Battery
+{
+public:
+	TizenBattery():
+		cb_(nullptr),
+		data_(nullptr)
+	{
+	}
+
+	~TizenBattery()
+	{
+		SetChangedCallback(nullptr, nullptr);
+	}
+
+	bool Percent(int* percent) override
+	{
+		return device_battery_get_percent(percent) == DEVICE_ERROR_NONE;
+	}
+
+	bool Charging(bool* charging) override
+	{
+		return device_battery_is_charging(charging) == DEVICE_ERROR_NONE;
+	}
+
+	void SetChangedCallback(ChangedCallback cb, void* data) override
+	{
+		static const device_callback_e types[] = { DEVICE_CALLBACK_BATTERY_CAPACITY, DEVICE_CALLBACK_BATTERY_CHARGING };
+		bool subscribed = cb_ != nullptr;
+		cb_ = cb;
+		data_ = data;
+		if (subscribed == (cb != nullptr)) {
+			return;
+		}
+		for (auto type: types) {
+			// The device callbacks have no user data on removal, so there is one subscriber
+			int ret = cb ? device_add_callback(type, deviceCallback, this) : device_remove_callback(type, deviceCallback);
+			if (ret != DEVICE_ERROR_NONE) {
+				LOG_E("device callback %d failed: %s", type, get_error_message(ret));
+			}
+		}
+	}
+private:
+	static void deviceCallback(device_callback_e type, void* value, void* data)
+	{
+		TizenBattery* battery = (TizenBattery*)data;
+		if (battery->cb_) {
+			battery->cb_(battery->data_);
+		}
+	}
+
+	ChangedCallback cb_;
+	void* data_;
+};
+
+class TizenConnectivity: public Connectivity
+{
+public:
+	TizenConnectivity():
+		connection_(NULL),
+		cb_(nullptr),
+		data_(nullptr)
+	{
+		// One handle for the app lifetime, requests come from worker threads
+		int ret = connection_create(&connection_);
+		if (ret != CONNECTION_ERROR_NONE) {
+			LOG_E("connection_create failed: %s", get_error_message(ret));
+			connection_ = NULL;
+			createError_ = ret;
+		}
+	}
+
+	~TizenConnectivity()
+	{
+		SetChangedCallback(nullptr, nullptr);
+		if (connection_) {
+			connection_destroy(connection_);
+		}
+	}
+
+	bool Online() override
+	{
+		connection_type_e type = CONNECTION_TYPE_DISCONNECTED;
+		if (!connection_ || connection_get_type(connection_, &type) != CONNECTION_ERROR_NONE) {
+			return false;
+		}
+		return type != CONNECTION_TYPE_DISCONNECTED;
+	}
+
+	void SetChangedCallback(ChangedCallback cb, void* data) override
+	{
+		bool subscribed = cb_ != nullptr;
+		cb_ = cb;
+		data_ = data;
+		if (!connection_ || subscribed == (cb != nullptr)) {
+			return;
+		}
+		int ret = cb ? connection_set_type_changed_cb(connection_, typeChangedCallback, this) : connection_unset_type_changed_cb(connection_);
+		if (ret != CONNECTION_ERROR_NONE) {
+			LOG_E("connection type changed cb failed: %s", get_error_message(ret));
+		}
+	}
+
+	int Proxy(std::string& proxy) override
+	{
+		proxy.clear();
+		if (!connection_) {
+			return createError_;
+		}
+		char* proxyAddress = nullptr;
+		int ret = connection_get_proxy(connection_, CONNECTION_ADDRESS_FAMILY_IPV4, &proxyAddress);
+		if (ret != CONNECTION_ERROR_NONE) {
+			LOG_E("connection_get_proxy failed: %s", get_error_message(ret));
+			return ret;
+		}
+		if (proxyAddress) {
+			proxy = proxyAddress;
+			free(proxyAddress);
+		}
+		return 0;
+	}
+private:
+	static void typeChangedCallback(connection_type_e type, void* data)
+	{
+		TizenConnectivity* connectivity = (TizenConnectivity*)data;
+		if (connectivity->cb_) {
+			connectivity->cb_(connectivity->data_);
+		}
+	}
+
+	connection_h connection_;
+	ChangedCallback cb_;
+	void* data_;
+	int createError_ = 0;
+};
+
+struct MainLoop::Timeout
+{
+	Ecore_Timer* timer;
+	Callback cb;
+	void* data;
+};
+
+class TizenMainLoop: public MainLoop
+{
+public:
+	void Post(Callback cb, void* data) override
+	{
+		ecore_main_loop_thread_safe_call_async(cb, data);
+	}
+
+	Timeout* AddTimeout(double seconds, Callback cb, void* data) override
+	{
+		Timeout* timeout = new Timeout{ nullptr, cb, data };
+		timeout->timer = ecore_timer_add(seconds, timerCallback, timeout);
+		if (!timeout->timer) {
+			delete timeout;
+			return nullptr;
+		}
+		return timeout;
+	}
+
+	void DeleteTimeout(Timeout* timeout) override
+	{
+		ecore_timer_del(timeout->timer);
+		delete timeout;
+	}
+private:
+	static Eina_Bool timerCallback(void* data)
+	{
+		// Gone before the callback, which may add the next one
+		Timeout* timeout = (Timeout*)data;
+		Callback cb = timeout->cb;
+		void* cbData = timeout->data;
+		delete timeout;
+		cb(cbData);
+		return ECORE_CALLBACK_CANCEL;
+	}
+};
+
+static TizenClock* TheClock = nullptr;
+static TizenLogger* TheLogger = nullptr;
+static TizenSensors* TheSensors = nullptr;
+static TizenLocation* TheLocation = nullptr;
+static TizenBattery* TheBattery = nullptr;
+static TizenConnectivity* TheConnectivity = nullptr;
+static TizenMainLoop* TheMainLoop = nullptr;
+
+void TizenPlatform::Install()
+{
+	TheClock = new TizenClock();
+	TheLogger = new TizenLogger();
+	TheSensors = new TizenSensors();
+	TheLocation = new TizenLocation();
+	TheBattery = new TizenBattery();
+	TheConnectivity = new TizenConnectivity();
+	TheMainLoop = new TizenMainLoop();
+	Platform::Install({ TheClock, TheLogger, TheSensors, TheLocation, TheBattery, TheConnectivity, TheMainLoop });
+}
+
+void TizenPlatform::Uninstall()
+{
+	Platform::Install({ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr });
+	delete TheMainLoop;
+	delete TheConnectivity;
+	delete TheBattery;
+	delete TheLocation;
+	delete TheSensors;
+	delete TheLogger;
+	delete TheClock;
+}
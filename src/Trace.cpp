@@ -0,0 +1,183 @@
+#include <math.h>
+#include "Trace.h"
+#include "Platform.h"
+#include "Log.h"
+
+static constexpr uint32_t traceMagic = 0x5254574f; // "OWTR"
+static constexpr uint32_t traceVersion = 2;
+// How far off the one second step a tick may be and still join a run
+static constexpr uint32_t tickSlack = 100;
+
+static const char* KindNames[] = {
+		"tick",
+		"visibility",
+		"sensor",
+		"location start",
+		"location stop",
+		"location fix",
+		"http",
+		"battery",
+		"connectivity",
+		"time changed"
+};
+
+static_assert(sizeof(KindNames) / sizeof(KindNames[0]) == Trace::KINDS_NUM, "Kind name missing");
+static_assert(sizeof(Trace::Record) == 16, "Trace records are 16 bytes");
+
+Trace::Trace():
+	file_(nullptr),
+	start_(0),
+	monotonicStart_(0),
+	buffered_(0),
+	written_(0)
+{
+}
+
+Trace::~Trace()
+{
+	Close();
+}
+
+bool Trace::Open(const char* path)
+{
+	Close();
+	file_ = fopen(path, "wb");
+	if (!file_) {
+		LOG_E("Failed to open trace %s", path);
+		return false;
+	}
+	start_ = (int64_t)(Platform::Get().clock->Now() * 1000);
+	monotonicStart_ = Platform::Get().clock->Monotonic();
+	Header header = { traceMagic, traceVersion, start_ };
+	if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+		LOG_E("Failed to write trace header");
+		Close();
+		return false;
+	}
+	written_ = 0;
+	return true;
+}
+
+void Trace::Close()
+{
+	if (!file_) {
+		return;
+	}
+	Flush();
+	fclose(file_);
+	file_ = nullptr;
+}
+
+void Trace::Add(Kind kind, int arg0/* = 0*/, int arg1/* = 0*/, int count/* = 1*/)
+{
+	Record* record = append(kind);
+	if (!record) {
+		return;
+	}
+	record->count = count < 0 ? 0 : (count > UINT16_MAX ? UINT16_MAX : count);
+	record->args[0] = arg0;
+	record->args[1] = arg1;
+}
+
+void Trace::Tick()
+{
+	if (!file_) {
+		return;
+	}
+	uint32_t time = elapsed();
+	if (buffered_ > 0) {
+		Record& last = buffer_[buffered_ - 1];
+		uint32_t expected = last.time + last.count * 1000;
+		if (last.kind == KIND_TICK && last.count < UINT16_MAX &&
+				time + tickSlack >= expected && time <= expected + tickSlack) {
+			++last.count;
+			return;
+		}
+	}
+	Add(KIND_TICK);
+}
+
+void Trace::TimeChanged()
+{
+	if (!file_) {
+		return;
+	}
+	double offset = Platform::Get().clock->Now() - start_ / 1000.0 - elapsed() / 1000.0;
+	Add(KIND_TIME_CHANGED, (int)lround(offset));
+}
+
+void Trace::Flush()
+{
+	if (!file_ || buffered_ == 0) {
+		return;
+	}
+	if (fwrite(buffer_, sizeof(Record), buffered_, file_) != (size_t)buffered_) {
+		LOG_E("Failed to write trace, recording stopped");
+		buffered_ = 0;
+		fclose(file_);
+		file_ = nullptr;
+		return;
+	}
+	fflush(file_);
+	written_ += buffered_;
+	buffered_ = 0;
+}
+
+Trace::Record* Trace::append(Kind kind)
+{
+	if (!file_) {
+		return nullptr;
+	}
+	if (buffered_ == bufferSize) {
+		Flush();
+		if (!file_) {
+			return nullptr;
+		}
+	}
+	if (written_ + buffered_ >= maxRecords) {
+		LOG_W("Trace is full, recording stopped");
+		Close();
+		return nullptr;
+	}
+	Record* record = &buffer_[buffered_++];
+	record->time = elapsed();
+	record->kind = kind;
+	return record;
+}
+
+// Suspended time counts, a watch sleeps between ambient ticks and over
+// the night and the records have to keep their spacing
+uint32_t Trace::elapsed() const
+{
+	return (uint32_t)((Platform::Get().clock->Monotonic() - monotonicStart_) * 1000);
+}
+
+bool Trace::Load(const char* path, double* start, std::vector<Record>& records)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+	Header header;
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+			header.magic != traceMagic || header.version != traceVersion) {
+		fclose(file);
+		return false;
+	}
+	*start = header.start / 1000.0;
+	records.clear();
+	Record record;
+	while (fread(&record, sizeof(record), 1, file) == 1) {
+		if (record.kind >= KINDS_NUM) {
+			break;
+		}
+		records.push_back(record);
+	}
+	fclose(file);
+	return true;
+}
+
+const char* Trace::KindName(Kind kind)
+{
+	return KindNames[kind];
+}
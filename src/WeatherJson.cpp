@@ -0,0 +1,115 @@
+#include "WeatherInfo.h"
+#include <stdio.h>
+#include <string.h>
+#include <json-glib/json-glib.h>
+
+#include <functional>
+#include <memory>
+
+static JsonNode* getNode(JsonObject* parent, const char* name)
+{
+	auto size = json_object_get_size (parent);
+	auto keysList = json_object_get_members (parent);
+	auto valList = json_object_get_values (parent);
+	JsonNode* res = nullptr;
+	for (decltype(size) i=0; i<size; ++i) {
+		if (!keysList || !valList) {
+			break;
+		}
+	    if (!strcmp(static_cast<gchar*>(keysList->data), name)) {
+	    	res = static_cast<JsonNode*>(valList->data);
+	    	break;
+	    }
+		keysList = g_list_next(keysList);
+		valList = g_list_next(valList);
+	}
+	g_list_free(keysList);
+	g_list_free(valList);
+	return res;
+}
+
+static JsonNode* getNodePath(JsonObject* parent, const char* path)
+{
+	char workPath[128];
+	char* savePtr = nullptr;
+	strcpy(workPath, path);
+	// Parsing runs on a worker thread, so no strtok
+	char* pathItr = strtok_r(workPath, "/", &savePtr);
+	JsonObject* objItr = parent;
+	JsonNode* nodeItr = nullptr;
+	while (pathItr) {
+		int idx = -1;
+		char* arr = strchr(pathItr, '[');
+		if (arr) {
+			sscanf(arr, "[%d]", &idx);
+			*arr = '\0';
+		}
+		if (!objItr) {
+			return nullptr;
+		}
+		nodeItr = getNode(objItr, pathItr);
+		if (!nodeItr) {
+			return nullptr;
+		}
+		if (idx > -1) {
+			JsonArray* jsonArray = json_node_get_array(nodeItr);
+			if (!jsonArray) {
+				return nullptr;
+			}
+			guint arraySize = json_array_get_length(jsonArray);
+			if (arraySize < idx + 1) {
+				return nullptr;
+			}
+			nodeItr = json_array_get_element(jsonArray,idx);
+		}
+		objItr = json_node_get_object(nodeItr);
+		pathItr = strtok_r(nullptr, "/", &savePtr);
+	}
+	return nodeItr;
+}
+
+bool WeatherInfo::FromJson(const char* json)
+{
+	GError *error = nullptr;
+	auto jsonParser = std::unique_ptr<JsonParser, std::function<void(JsonParser*)>>(json_parser_new(), [](JsonParser* p){g_object_unref(p);});
+	json_parser_load_from_data(jsonParser.get(), json, strlen(json), &error);
+	if (error) {
+		g_error_free(error);
+		return false;
+	}
+
+	JsonNode *root;
+    root = json_parser_get_root(jsonParser.get());
+    if (!root) {
+    	return false;
+    }
+    if (JSON_NODE_TYPE(root) != JSON_NODE_OBJECT) {
+    	return false;
+    }
+    JsonObject* rootObj = json_node_get_object(root);
+
+    // Name
+    JsonNode* nameNode = getNode(rootObj, "name");
+    if (!nameNode || (json_node_get_value_type(nameNode) != G_TYPE_STRING)) {
+    	return false;
+    }
+
+	// Icon
+	JsonNode* iconNode = getNodePath(rootObj, "weather[0]/icon");
+    if (!iconNode || (json_node_get_value_type(iconNode) != G_TYPE_STRING)) {
+    	 return false;
+    }
+
+	// Temp
+    JsonNode* tempNode = getNodePath(rootObj, "main/temp");
+    if (!tempNode || (json_node_get_value_type(tempNode) != G_TYPE_DOUBLE)) {
+    	return false;
+    }
+
+	gchar* name = json_node_dup_string(nameNode);
+	gchar* icon = json_node_dup_string(iconNode);
+	set(name, icon, json_node_get_double(tempNode));
+	g_free(name);
+	g_free(icon);
+    return true;
+}
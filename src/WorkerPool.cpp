@@ -0,0 +1,116 @@
+#include "WorkerPool.h"
+#include "Platform.h"
+
+WorkerPool& WorkerPool::GetInstance()
+{
+	static WorkerPool instance;
+	return instance;
+}
+
+bool WorkerPool::OnMainThread()
+{
+	return std::this_thread::get_id() == GetInstance().mainThread_;
+}
+
+WorkerPool::WorkerPool():
+	stopping_(false),
+	trimming_(false),
+	busy_(0),
+	mainThread_(std::this_thread::get_id())
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+	Shutdown();
+}
+
+void WorkerPool::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+		jobs_.clear();
+	}
+	cond_.notify_all();
+	for (auto& thread: threads_) {
+		thread.join();
+	}
+	threads_.clear();
+}
+
+bool WorkerPool::Trim()
+{
+	std::vector<std::thread> threads;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (stopping_ || busy_ > 0 || !jobs_.empty()) {
+			return false;
+		}
+		trimming_ = true;
+		threads.swap(threads_);
+	}
+	cond_.notify_all();
+	for (auto& thread: threads) {
+		thread.join();
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	trimming_ = false;
+	return true;
+}
+
+bool WorkerPool::Idle()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return busy_ == 0 && jobs_.empty();
+}
+
+void WorkerPool::post(std::function<void()>&& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (stopping_) {
+			return;
+		}
+		jobs_.push_back(std::move(job));
+		// Threads are started on first use
+		if (threads_.empty()) {
+			for (int i = 0; i < threadsNum; ++i) {
+				threads_.emplace_back(&WorkerPool::workerLoop, this);
+			}
+		}
+	}
+	cond_.notify_one();
+}
+
+void WorkerPool::workerLoop()
+{
+	for (;;) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cond_.wait(lock, [this]() { return stopping_ || trimming_ || !jobs_.empty(); });
+			if (stopping_ || trimming_) {
+				return;
+			}
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+			++busy_;
+		}
+		job();
+		std::lock_guard<std::mutex> lock(mutex_);
+		--busy_;
+	}
+}
+
+void WorkerPool::runOnMainLoop(std::function<void()>&& job)
+{
+	Platform::Get().mainLoop->Post(WorkerPool::mainLoopCallback, new std::function<void()>(std::move(job)));
+}
+
+void WorkerPool::mainLoopCallback(void* data)
+{
+	std::function<void()>* job = static_cast<std::function<void()>*>(data);
+	(*job)();
+	delete job;
+}
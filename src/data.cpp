@@ -8,10 +8,25 @@
 
 void data_get_resource_path(const char *file_in, char *file_path_out, int file_path_max)
 {
-	char *res_path = app_get_resource_path();
-	if (res_path) {
-		snprintf(file_path_out, file_path_max, "%s%s", res_path, file_in);
-		free(res_path);
+	// app_get_resource_path() returns a fresh copy each time, keep the first one
+	static char res_path[PATH_MAX] = { 0, };
+	if (!res_path[0]) {
+		char *path = app_get_resource_path();
+		if (!path) {
+			return;
+		}
+		snprintf(res_path, sizeof(res_path), "%s", path);
+		free(path);
+	}
+	snprintf(file_path_out, file_path_max, "%s%s", res_path, file_in);
+}
+
+void data_get_data_path(const char *file_in, char *file_path_out, int file_path_max)
+{
+	char *data_path = app_get_data_path();
+	if (data_path) {
+		snprintf(file_path_out, file_path_max, "%s%s", data_path, file_in);
+		free(data_path);
 	}
 }
 
@@ -15,16 +15,20 @@
  */
 
 #include <tizen.h>
+#include <dlog.h>
 #include <app.h>
 #include <watch_app.h>
 #include <watch_app_efl.h>
 #include <system_settings.h>
 #include <efl_extension.h>
-#include <dlog.h>
 #include <omahawatch.h>
 
 #include "data.h"
 #include "Face.h"
+#include "WorkerPool.h"
+#include "TizenPlatform.h"
+#include "Stats.h"
+#include "Log.h"
 
 static Face* face = NULL;
 
@@ -70,9 +74,11 @@ void region_changed(app_event_info_h event_info, void* user_data)
 void low_battery(app_event_info_h event_info, void* user_data)
 {
 	/*
-	 * Takes necessary actions when system is running on low battery
+	 * Drop to the lowest power tier instead of closing the face
 	 */
-	watch_app_exit();
+	if (face) {
+		face->LowBattery();
+	}
 }
 
 /*
@@ -83,9 +89,13 @@ void low_battery(app_event_info_h event_info, void* user_data)
 void low_memory(app_event_info_h event_info, void* user_data)
 {
 	/*
-	 * Takes necessary actions when system is running on low memory
+	 * Release memory in tiers instead of closing the face
 	 */
-	watch_app_exit();
+	app_event_low_memory_status_e status = APP_EVENT_LOW_MEMORY_NORMAL;
+	app_event_get_low_memory_status(event_info, &status);
+	if (face) {
+		face->LowMemory(status);
+	}
 }
 
 /*
@@ -113,31 +123,34 @@ static bool app_create(int width, int height, void* user_data)
 	 * Initialize UI resources and application's data
 	 */
 
+	// Before anything logs, LOG_E and friends drop messages without a platform
+	TizenPlatform::Install();
+
 	app_event_handler_h handlers[5] = { NULL, };
 
 	/*
 	 * Register callbacks for each system event
 	 */
 	if (watch_app_add_event_handler(&handlers[APP_EVENT_LANGUAGE_CHANGED], APP_EVENT_LANGUAGE_CHANGED, lang_changed, NULL) != APP_ERROR_NONE)
-		dlog_print(DLOG_ERROR, LOG_TAG, "watch_app_add_event_handler () is failed");
+		LOG_E("watch_app_add_event_handler () is failed");
 
 	if (watch_app_add_event_handler(&handlers[APP_EVENT_REGION_FORMAT_CHANGED], APP_EVENT_REGION_FORMAT_CHANGED, region_changed, NULL) != APP_ERROR_NONE)
-		dlog_print(DLOG_ERROR, LOG_TAG, "watch_app_add_event_handler () is failed");
+		LOG_E("watch_app_add_event_handler () is failed");
 
 	if (watch_app_add_event_handler(&handlers[APP_EVENT_LOW_BATTERY], APP_EVENT_LOW_BATTERY, low_battery, NULL) != APP_ERROR_NONE)
-		dlog_print(DLOG_ERROR, LOG_TAG, "watch_app_add_event_handler () is failed");
+		LOG_E("watch_app_add_event_handler () is failed");
 
 	if (watch_app_add_event_handler(&handlers[APP_EVENT_LOW_MEMORY], APP_EVENT_LOW_MEMORY, low_memory, NULL) != APP_ERROR_NONE)
-		dlog_print(DLOG_ERROR, LOG_TAG, "watch_app_add_event_handler () is failed");
+		LOG_E("watch_app_add_event_handler () is failed");
 
 	if (watch_app_add_event_handler(&handlers[APP_EVENT_DEVICE_ORIENTATION_CHANGED], APP_EVENT_DEVICE_ORIENTATION_CHANGED, device_orientation, NULL) != APP_ERROR_NONE)
-		dlog_print(DLOG_ERROR, LOG_TAG, "watch_app_add_event_handler () is failed");
+		LOG_E("watch_app_add_event_handler () is failed");
 
-	dlog_print(DLOG_DEBUG, LOG_TAG, "%s", __func__);
+	LOG_D("%s", __func__);
 
 	face = new Face(width, height);
 	if (!face->Init()) {
-		dlog_print(DLOG_ERROR, LOG_TAG, "Failed initializing watch. Too bad :(");
+		LOG_E("Failed initializing watch. Too bad :(");
 		watch_app_exit();
 	}
 
@@ -152,7 +165,17 @@ static bool app_create(int width, int height, void* user_data)
  */
 static void app_control(app_control_h app_control, void *user_data)
 {
-	dlog_print(DLOG_DEBUG, LOG_TAG, "app_control");
+	LOG_D("app_control");
+	char* theme = NULL;
+	if (face && app_control_get_extra_data(app_control, THEME_CONTROL_EXTRA, &theme) == APP_CONTROL_ERROR_NONE && theme) {
+		face->SetTheme(theme);
+		free(theme);
+	}
+	char* quiet = NULL;
+	if (face && app_control_get_extra_data(app_control, QUIET_CONTROL_EXTRA, &quiet) == APP_CONTROL_ERROR_NONE && quiet) {
+		face->SetQuietSchedule(quiet);
+		free(quiet);
+	}
 }
 
 /*
@@ -161,7 +184,7 @@ static void app_control(app_control_h app_control, void *user_data)
  */
 static void app_pause(void *user_data)
 {
-	dlog_print(DLOG_DEBUG, LOG_TAG, "app_pause");
+	LOG_D("app_pause");
 	face->PauseAnimator();
 }
 
@@ -171,7 +194,7 @@ static void app_pause(void *user_data)
  */
 static void app_resume(void *user_data)
 {
-	dlog_print(DLOG_DEBUG, LOG_TAG, "app_resume");
+	LOG_D("app_resume");
 	face->ResumeAnimator();
 }
 
@@ -181,9 +204,11 @@ static void app_resume(void *user_data)
  */
 static void app_terminate(void *user_data)
 {
-	dlog_print(DLOG_DEBUG, LOG_TAG, "app_terminate");
+	LOG_D("app_terminate");
 	delete face;
 	face = NULL;
+	WorkerPool::GetInstance().Shutdown();
+	TizenPlatform::Uninstall();
 }
 
 /*
@@ -193,6 +218,7 @@ static void app_terminate(void *user_data)
  */
 void app_time_tick(watch_time_h watch_time, void* user_data)
 {
+	Stats::Add(Stats::TIME_TICKS);
 	face->Tick(watch_time);
 }
 
@@ -203,6 +229,7 @@ void app_time_tick(watch_time_h watch_time, void* user_data)
  */
 void app_ambient_tick(watch_time_h watch_time, void* user_data)
 {
+	Stats::Add(Stats::AMBIENT_TICKS);
 	face->Tick(watch_time);
 }
 
@@ -213,9 +240,7 @@ void app_ambient_tick(watch_time_h watch_time, void* user_data)
  */
 void app_ambient_changed(bool ambient_mode, void* user_data)
 {
-	if (!face->ToggleAmbient(ambient_mode)) {
-		watch_app_exit();
-	}
+	face->ToggleAmbient(ambient_mode);
 }
 
 /*
@@ -237,6 +262,7 @@ int main(int argc, char *argv[])
 	event_callback.ambient_changed = app_ambient_changed;
 
 	ret = watch_app_main(argc, argv, &event_callback, NULL);
+	// The platform is gone or was never installed, straight to dlog
 	if (ret != APP_ERROR_NONE)
 		dlog_print(DLOG_ERROR, LOG_TAG, "watch_app_main() is failed. err = %d", ret);
 